@@ -0,0 +1,165 @@
+#include "AutoSaver.h"
+#include <string>
+#include <chrono>
+#include <cstdio>
+
+#ifndef _WIN32
+#include <unistd.h>
+#endif
+
+AutoSaver::AutoSaver() : m_hasPending(false), m_writing(false), m_stopping(false), m_stats() {}
+
+AutoSaver::~AutoSaver() {
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stopping = true;
+    }
+    m_wake.notify_one();
+
+    if (m_worker.joinable()) {
+        m_worker.join();
+    }
+}
+
+bool AutoSaver::writeFile(const LineRope& lines, const std::string& file, long long& bytesWritten) {
+    // Write to a temporary file next to the real one and only replace the real one once every byte is on disk
+    // That way a failed save never destroys the old file, and untouched lines can keep being read out of the
+    // loaded file even if it's the one being saved over (renaming over a mapped file leaves the mapping intact)
+    std::string tempFile = file + ".tmp";
+    std::FILE* outfile = std::fopen(tempFile.c_str(), "wb");
+    if (outfile == nullptr) {
+        return false;
+    }
+    // Our buffer is already much larger than the stream's would be, so there's no point in copying into both
+    std::setvbuf(outfile, nullptr, _IONBF, 0);
+
+    // Assemble lines into a large buffer and write it out whenever it fills up, so the number of
+    // write calls depends on the size of the document rather than on how many lines it has
+    const size_t BUFFER_SIZE = 1 << 20;
+    std::string buffer;
+    buffer.reserve(BUFFER_SIZE + 4096);
+
+    bytesWritten = 0;
+    bool ok = true;
+    for (LineRope::Iterator it = lines.iterate(0); !it.done() && ok; it.next()) {
+        buffer += it.view();
+        buffer += '\n';
+
+        if (buffer.length() >= BUFFER_SIZE) {
+            ok = std::fwrite(buffer.data(), 1, buffer.length(), outfile) == buffer.length();
+            bytesWritten += buffer.length();
+            buffer.clear();
+        }
+    }
+    if (ok && !buffer.empty()) {
+        ok = std::fwrite(buffer.data(), 1, buffer.length(), outfile) == buffer.length();
+        bytesWritten += buffer.length();
+    }
+
+    // Make sure the data has actually reached the disk before the rename makes it visible
+    ok = ok && std::fflush(outfile) == 0;
+#ifndef _WIN32
+    ok = ok && fsync(fileno(outfile)) == 0;
+#endif
+    ok = std::fclose(outfile) == 0 && ok;
+
+#ifdef _WIN32
+    // Windows won't rename over an existing file
+    if (ok) {
+        std::remove(file.c_str());
+    }
+#endif
+    if (!ok || std::rename(tempFile.c_str(), file.c_str()) != 0) {
+        std::remove(tempFile.c_str());
+        return false;
+    }
+
+    return true;
+}
+
+void AutoSaver::request(const LineRope& snapshot, const std::string& file, double snapshotSeconds) {
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+
+        // A request that hasn't been started yet is out of date now, so it's simply replaced
+        if (m_hasPending) {
+            m_stats.coalesced++;
+        }
+        m_pending.lines = snapshot;
+        m_pending.file = file;
+        m_pending.requestTime = std::chrono::steady_clock::now();
+        m_hasPending = true;
+
+        m_stats.requests++;
+        m_stats.lastSnapshotSeconds = snapshotSeconds;
+        if (snapshotSeconds > m_stats.maxSnapshotSeconds) {
+            m_stats.maxSnapshotSeconds = snapshotSeconds;
+        }
+
+        if (!m_worker.joinable()) {
+            m_worker = std::thread(&AutoSaver::workLoop, this);
+        }
+    }
+    m_wake.notify_one();
+}
+
+void AutoSaver::cancel() {
+    std::unique_lock<std::mutex> lock(m_mutex);
+    if (m_hasPending) {
+        // Let go of the snapshot now, so the editor doesn't have to copy nodes it shares
+        m_pending.lines.clear();
+        m_hasPending = false;
+    }
+    m_idle.wait(lock, [this] { return !m_writing; });
+}
+
+void AutoSaver::wait() {
+    std::unique_lock<std::mutex> lock(m_mutex);
+    m_idle.wait(lock, [this] { return !m_writing && !m_hasPending; });
+}
+
+AutoSaver::Stats AutoSaver::stats() const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_stats;
+}
+
+void AutoSaver::workLoop() {
+    std::unique_lock<std::mutex> lock(m_mutex);
+    while (true) {
+        m_wake.wait(lock, [this] { return m_stopping || m_hasPending; });
+        if (m_stopping) {
+            break;
+        }
+
+        // Take the request, so new ones can come in while this one is being written
+        Request request;
+        request.lines = m_pending.lines;
+        request.file.swap(m_pending.file);
+        request.requestTime = m_pending.requestTime;
+        m_pending.lines.clear();
+        m_hasPending = false;
+        m_writing = true;
+        lock.unlock();
+
+        std::chrono::steady_clock::time_point startTime = std::chrono::steady_clock::now();
+        long long bytesWritten;
+        bool ok = writeFile(request.lines, request.file, bytesWritten);
+        std::chrono::steady_clock::time_point endTime = std::chrono::steady_clock::now();
+        request.lines.clear();
+
+        lock.lock();
+        if (ok) {
+            m_stats.saves++;
+            m_stats.lastBytes = bytesWritten;
+            m_stats.lastWriteSeconds = std::chrono::duration<double>(endTime - startTime).count();
+            m_stats.lastLatencySeconds = std::chrono::duration<double>(endTime - request.requestTime).count();
+            if (m_stats.lastLatencySeconds > m_stats.maxLatencySeconds) {
+                m_stats.maxLatencySeconds = m_stats.lastLatencySeconds;
+            }
+        } else {
+            m_stats.failures++;
+        }
+        m_writing = false;
+        m_idle.notify_all();
+    }
+}
\ No newline at end of file
@@ -0,0 +1,70 @@
+#ifndef AUTOSAVER_H_
+#define AUTOSAVER_H_
+
+#include "LineRope.h"
+
+#include <string>
+#include <mutex>
+#include <condition_variable>
+#include <thread>
+#include <chrono>
+
+// Writes snapshots of a document to disk on a worker thread, so saving never holds up editing.
+// Only the newest request matters: if requests come in faster than the disk can keep up, whatever
+// is still waiting when a new one arrives is dropped in favor of it.
+class AutoSaver {
+public:
+    // What the saver has done so far; times are in seconds
+    struct Stats {
+        int requests;           // Number of saves requested
+        int saves;              // Number of snapshots written
+        int coalesced;          // Number of requests dropped because a newer one replaced them
+        int failures;           // Number of writes that failed
+        double lastSnapshotSeconds;     // How long the editor took to make the last snapshot
+        double maxSnapshotSeconds;
+        double lastLatencySeconds;      // Time from the last written request being made until it was on disk
+        double maxLatencySeconds;
+        double lastWriteSeconds;        // Time spent writing the last snapshot
+        long long lastBytes;            // Size of the last snapshot written
+    };
+
+    AutoSaver();
+    // Finishes the request being written (if any), but drops one still waiting
+    ~AutoSaver();
+
+    // Write every line of lines to file followed by a newline, storing how many bytes were written in bytesWritten
+    // The lines go to a temporary file that's synced to disk and renamed over file, so file is never left half written
+    static bool writeFile(const LineRope& lines, const std::string& file, long long& bytesWritten);
+
+    // Ask for a snapshot to be written to file, replacing any request that hasn't been started yet
+    // snapshotSeconds is how long the snapshot took to make, which is only recorded in the stats
+    void request(const LineRope& snapshot, const std::string& file, double snapshotSeconds);
+    // Drop the waiting request (if any) and wait for the one being written to finish
+    void cancel();
+    // Wait until every request made so far has been written
+    void wait();
+    // Return a copy of the stats
+    Stats stats() const;
+private:
+    // A request waiting to be written
+    struct Request {
+        LineRope lines;
+        std::string file;
+        std::chrono::steady_clock::time_point requestTime;
+    };
+
+    mutable std::mutex m_mutex;     // Guards everything below
+    std::condition_variable m_wake;     // Signaled when there's a request to write or the saver is stopping
+    std::condition_variable m_idle;     // Signaled whenever a write finishes
+    Request m_pending;
+    bool m_hasPending;
+    bool m_writing;             // Whether the worker is in the middle of writing a request
+    bool m_stopping;
+    Stats m_stats;
+    std::thread m_worker;       // Started by the first request
+
+    // Write requests as they come in until the saver is destroyed (run by m_worker)
+    void workLoop();
+};
+
+#endif // AUTOSAVER_H_
\ No newline at end of file
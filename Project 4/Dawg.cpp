@@ -0,0 +1,267 @@
+#include "Dawg.h"
+#include "DoubleArrayTrie.h"
+#include <string>
+#include <string_view>
+#include <vector>
+#include <utility>
+#include <unordered_set>
+#include <algorithm>
+#include <cctype>
+#include <cstdint>
+#ifdef _MSC_VER
+#include <xmmintrin.h>
+#endif
+
+namespace {
+
+// The code of every byte, the same as DoubleArrayTrie's, so mapping a character is one table lookup
+struct CodeTable {
+    signed char codes[256];
+
+    CodeTable() {
+        for (int i = 0; i < 256; i++) {
+            codes[i] = DoubleArrayTrie::NO_CODE;
+        }
+        for (int code = 1; code < DoubleArrayTrie::NUM_CODES; code++) {
+            char ch = DoubleArrayTrie::character(code);
+            codes[(unsigned char) ch] = code;
+            codes[(unsigned char) toupper(ch)] = code;
+        }
+    }
+};
+
+// A state along the word being added, whose edges may still change
+struct OpenState {
+    bool endsWord;
+    std::vector<std::pair<int, int>> edges;     // Code and finished state, in the order they were added
+};
+
+}
+
+static const CodeTable CODE_TABLE;
+
+// How the fields of an edge are packed
+const uint32_t CODE_MASK = 0x1F;
+const uint32_t LAST = 1u << 5;
+const uint32_t ENDS_WORD = 1u << 6;
+const int EDGES_SHIFT = 7;
+
+Dawg::Dawg() {
+    // An empty graph is an edge to a root with no edges
+    m_edges.push_back(0);
+}
+
+// Time Complexity: O(W log W) for W words to sort them, then O(C) for C characters in all, since each state is
+// finished once, when the words after it have moved on to another prefix
+void Dawg::build(std::vector<std::string>& words) {
+    // Both cases of a letter have the same code, so they have to sort together
+    for (std::string& word : words) {
+        for (char& ch : word) {
+            ch = DoubleArrayTrie::character(CODE_TABLE.codes[(unsigned char) ch]);
+        }
+    }
+    std::sort(words.begin(), words.end());
+    words.erase(std::unique(words.begin(), words.end()), words.end());
+
+    // The finished states, which never change again: state s's edges are edges[firstEdge[s], firstEdge[s + 1])
+    std::vector<bool> ends;
+    std::vector<int> firstEdge(1, 0);
+    std::vector<std::pair<int, int>> edges;
+    auto hash = [&](int state) {
+        size_t value = ends[state];
+        for (int i = firstEdge[state]; i < firstEdge[state + 1]; i++) {
+            value = value * 31 + edges[i].first;
+            value = value * 1000003 + edges[i].second;
+        }
+        return value;
+    };
+    auto equal = [&](int a, int b) {
+        return ends[a] == ends[b] && firstEdge[a + 1] - firstEdge[a] == firstEdge[b + 1] - firstEdge[b]
+            && std::equal(edges.begin() + firstEdge[a], edges.begin() + firstEdge[a + 1], edges.begin() + firstEdge[b]);
+    };
+    std::unordered_set<int, decltype(hash), decltype(equal)> registered(1024, hash, equal);
+
+    // Finish state: add it, then take it back out if there was an equal one already, and return whichever stays
+    auto finish = [&](OpenState& state) {
+        // Its edges are compared and later found in order of their codes
+        std::sort(state.edges.begin(), state.edges.end());
+        int id = ends.size();
+        ends.push_back(state.endsWord);
+        edges.insert(edges.end(), state.edges.begin(), state.edges.end());
+        firstEdge.push_back(edges.size());
+
+        std::pair<std::unordered_set<int, decltype(hash), decltype(equal)>::iterator, bool> inserted = registered.insert(id);
+        if (!inserted.second) {
+            ends.pop_back();
+            firstEdge.pop_back();
+            edges.resize(firstEdge.back());
+            id = *inserted.first;
+        }
+        return id;
+    };
+
+    // The states along the previous word; path[i] is where its first i characters lead
+    // (the vector only grows, so the edges of its states are allocated once)
+    std::vector<OpenState> path(1);
+    size_t pathLength = 1;
+    path[0].endsWord = false;
+    for (size_t i = 0; i < words.size(); i++) {
+        // No later word can pass through the part of the previous word this one doesn't share, so finish it,
+        // deepest first so each state's children are already finished
+        size_t common = 0;
+        if (i > 0) {
+            const std::string& previous = words[i - 1];
+            while (common < previous.length() && common < words[i].length() && previous[common] == words[i][common]) {
+                common++;
+            }
+        }
+        for (; pathLength - 1 > common; pathLength--) {
+            // The state is always its parent's latest child, since the words are sorted
+            path[pathLength - 2].edges.back().second = finish(path[pathLength - 1]);
+        }
+
+        for (size_t j = common; j < words[i].length(); j++) {
+            if (path.size() == pathLength) {
+                path.emplace_back();
+            }
+            path[pathLength].endsWord = false;
+            path[pathLength].edges.clear();
+            path[pathLength - 1].edges.push_back(std::make_pair((int) CODE_TABLE.codes[(unsigned char) words[i][j]], -1));
+            pathLength++;
+        }
+        path[pathLength - 1].endsWord = true;
+    }
+    for (; pathLength > 1; pathLength--) {
+        path[pathLength - 2].edges.back().second = finish(path[pathLength - 1]);
+    }
+    int root = finish(path[0]);
+
+    // Lay out the edges of each state reachable from the root together, after the root's edge, depth first
+    // so the edges along a word are near each other
+    std::vector<int> starts(ends.size(), -1);
+    std::vector<int> order(1, root);
+    std::vector<std::pair<int, int>> stack(1, std::make_pair(root, firstEdge[root]));   // State and next edge
+    starts[root] = 1;
+    int numEdges = 1 + firstEdge[root + 1] - firstEdge[root];
+    while (!stack.empty()) {
+        std::pair<int, int>& top = stack.back();
+        if (top.second == firstEdge[top.first + 1]) {
+            stack.pop_back();
+            continue;
+        }
+
+        int next = edges[top.second].second;
+        top.second++;
+        if (starts[next] < 0) {
+            starts[next] = numEdges;
+            numEdges += firstEdge[next + 1] - firstEdge[next];
+            order.push_back(next);
+            stack.push_back(std::make_pair(next, firstEdge[next]));
+        }
+    }
+
+    // An edge holds its code and whether it's its state's last, then whether a word ends at the state it leads to
+    // and where that state's edges start (or 0 if it has none, since nothing leads back to the root)
+    auto edgeTo = [&](int state, int code, bool last) {
+        uint32_t edge = code | (last ? LAST : 0) | (ends[state] ? ENDS_WORD : 0);
+        if (firstEdge[state + 1] > firstEdge[state]) {
+            edge |= (uint32_t) starts[state] << EDGES_SHIFT;
+        }
+        return edge;
+    };
+    m_edges.resize(numEdges);
+    m_edges.shrink_to_fit();
+    m_edges[ROOT] = edgeTo(root, 0, true);
+    for (int state : order) {
+        for (int i = firstEdge[state]; i < firstEdge[state + 1]; i++) {
+            m_edges[starts[state] + i - firstEdge[state]] = edgeTo(edges[i].second, edges[i].first, i + 1 == firstEdge[state + 1]);
+        }
+    }
+}
+
+void Dawg::listWords(std::vector<std::string>& words) const {
+    words.clear();
+    std::string prefix;
+    listWords(ROOT, prefix, words);
+}
+
+bool Dawg::contains(std::string_view word) const {
+    int state = ROOT;
+    for (char ch : word) {
+        int code = CODE_TABLE.codes[(unsigned char) ch];
+        if (code == DoubleArrayTrie::NO_CODE) {
+            return false;
+        }
+        state = child(state, code);
+        if (state < 0) {
+            return false;
+        }
+    }
+
+    return endsWord(state);
+}
+
+int Dawg::child(int state, int code) const {
+    // The edges are in order of their codes, so the search can stop at the first one past code
+    uint32_t i = m_edges[state] >> EDGES_SHIFT;
+    if (i == 0) {
+        return -1;
+    }
+    for (;; i++) {
+        uint32_t edge = m_edges[i];
+        int edgeCode = edge & CODE_MASK;
+        if (edgeCode == code) {
+            return i;
+        }
+        if (edgeCode > code || (edge & LAST)) {
+            return -1;
+        }
+    }
+}
+
+uint32_t Dawg::childCodes(int state) const {
+    uint32_t codes = 0;
+    uint32_t i = m_edges[state] >> EDGES_SHIFT;
+    if (i == 0) {
+        return 0;
+    }
+    for (;; i++) {
+        codes |= 1u << (m_edges[i] & CODE_MASK);
+        if (m_edges[i] & LAST) {
+            return codes;
+        }
+    }
+}
+
+bool Dawg::endsWord(int state) const {
+    return m_edges[state] & ENDS_WORD;
+}
+
+void Dawg::prefetch(int state, uint32_t) const {
+    // A state's edges are next to each other, so whichever codes are followed, it's the same cache line or two
+    uint32_t i = m_edges[state] >> EDGES_SHIFT;
+#ifdef _MSC_VER
+    _mm_prefetch((const char*) &m_edges[i], _MM_HINT_T0);
+#else
+    __builtin_prefetch(&m_edges[i]);
+#endif
+}
+
+size_t Dawg::memoryUsage() const {
+    return m_edges.capacity() * sizeof(uint32_t);
+}
+
+void Dawg::listWords(int state, std::string& prefix, std::vector<std::string>& words) const {
+    if (endsWord(state)) {
+        words.push_back(prefix);
+    }
+
+    for (int code = 1; code < DoubleArrayTrie::NUM_CODES; code++) {
+        int next = child(state, code);
+        if (next >= 0) {
+            prefix += DoubleArrayTrie::character(code);
+            listWords(next, prefix, words);
+            prefix.pop_back();
+        }
+    }
+}
\ No newline at end of file
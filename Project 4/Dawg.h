@@ -0,0 +1,55 @@
+#ifndef DAWG_H_
+#define DAWG_H_
+
+#include <string>
+#include <string_view>
+#include <vector>
+#include <cstddef>
+#include <cstdint>
+
+// A minimal directed acyclic word graph: a trie in which every two states with the same set of endings
+// have been merged into one, so words share their common endings ("-ing", "-tion", "'s") as well as their
+// common beginnings, and the graph takes a fraction of the trie's memory.
+// It's built incrementally from the sorted words (Daciuk et al.): as each word is added, the states of the
+// previous word that no later word can pass through are either replaced with an equal state that's already
+// in the graph or registered as new, so the trie is never built in full.
+// The edges of each state are stored together in order of their character codes (DoubleArrayTrie's), and each
+// is packed into 4 bytes: its code, whether it's its state's last edge, whether a word ends at the state it
+// leads to, and where that state's edges start. So following a character is a short scan of one state's edges,
+// which are next to each other in memory, and states are referred to by the index of an edge leading to them.
+// That leaves 25 bits for where a state's edges start, so a graph can have up to 32 million edges, which is
+// dozens of times what the largest English word lists need.
+class Dawg {
+public:
+    // The state every word starts from
+    static const int ROOT = 0;
+
+    Dawg();
+
+    // Replace the contents of the graph with words, which may only hold characters that have codes
+    // words is lowercased, sorted and has its duplicates removed along the way
+    void build(std::vector<std::string>& words);
+    // Fill words with every word in the graph, in lowercase and in order of their codes
+    void listWords(std::vector<std::string>& words) const;
+    // Return whether word is in the graph, ignoring case
+    // Time Complexity: O(L) for a word of length L, with no allocations
+    bool contains(std::string_view word) const;
+    // Return the state reached by following code from state, or -1 if there isn't one
+    int child(int state, int code) const;
+    // Return a bit mask with bit c set for every code c that state has a child on
+    uint32_t childCodes(int state) const;
+    // Return whether a word ends at state
+    bool endsWord(int state) const;
+    // Start loading what following any of codes (a bit mask like childCodes's) from state reads into the cache,
+    // without waiting for it
+    void prefetch(int state, uint32_t codes) const;
+    // Return how many bytes the graph takes up
+    size_t memoryUsage() const;
+private:
+    std::vector<uint32_t> m_edges;      // The root's edge (an edge to the root from nowhere) comes first
+
+    // Add every word starting with prefix, which ends at state, to words
+    void listWords(int state, std::string& prefix, std::vector<std::string>& words) const;
+};
+
+#endif // DAWG_H_
\ No newline at end of file
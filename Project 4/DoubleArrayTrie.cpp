@@ -0,0 +1,287 @@
+#include "DoubleArrayTrie.h"
+#include <string>
+#include <string_view>
+#include <vector>
+#include <memory>
+#include <algorithm>
+#include <fstream>
+#include <cstring>
+#include <cstdio>
+#include <cstdint>
+
+// What every file written by save starts with
+const char MAGIC[8] = { 'D', 'A', 'T', 'R', 'I', 'E', '0', '1' };
+const int BYTE_ORDER_MARK = 0x01020304;
+
+// The code of every byte, so mapping a character is one table lookup
+struct CodeTable {
+    signed char codes[256];
+
+    CodeTable() {
+        for (int i = 0; i < 256; i++) {
+            codes[i] = DoubleArrayTrie::NO_CODE;
+        }
+        for (int i = 0; i < 26; i++) {
+            codes['a' + i] = i + 1;
+            codes['A' + i] = i + 1;
+        }
+        codes['\''] = DoubleArrayTrie::APOSTROPHE;
+    }
+};
+static const CodeTable CODE_TABLE;
+
+DoubleArrayTrie::DoubleArrayTrie() : m_nextFree(1) {
+    // An empty trie is a root whose children would all land on free cells
+    Cell free;
+    free.base = 0;
+    free.check = EMPTY;
+    m_cells.assign(1 + NUM_CODES, free);
+    m_cells[ROOT].base = 1;
+    m_cells[ROOT].check = ROOT;
+    m_data = m_cells.data();
+    m_numCells = m_cells.size();
+}
+
+// Time Complexity: O(W log W) for W words to sort them, then about O(S) for S states while the array stays dense
+void DoubleArrayTrie::build(std::vector<std::string>& words) {
+    // Both cases of a letter have the same code, so they have to sort together
+    for (std::string& word : words) {
+        for (char& ch : word) {
+            ch = character(CODE_TABLE.codes[(unsigned char) ch]);
+        }
+    }
+    std::sort(words.begin(), words.end());
+    words.erase(std::unique(words.begin(), words.end()), words.end());
+
+    Cell free;
+    free.base = 0;
+    free.check = EMPTY;
+    m_cells.assign(1 + NUM_CODES, free);
+    m_cells[ROOT].base = 1;
+    m_cells[ROOT].check = ROOT;
+    m_nextFree = 1;
+
+    buildState(ROOT, words, 0, words.size(), 0);
+
+    // Trim the free cells off the end, but keep every state's children inside the array
+    // so lookups never have to check bounds
+    size_t size = 1;
+    for (size_t i = 0; i < m_cells.size(); i++) {
+        if (m_cells[i].check != EMPTY) {
+            size = std::max(size, std::max(i + 1, (size_t) m_cells[i].base + NUM_CODES));
+        }
+    }
+    m_cells.resize(size);
+    m_cells.shrink_to_fit();
+
+    // Whatever file the trie was mapped from isn't needed anymore
+    m_file.reset();
+    m_data = m_cells.data();
+    m_numCells = m_cells.size();
+}
+
+bool DoubleArrayTrie::save(const std::string& file) const {
+    // Other processes may have the old file mapped, and writing over it would change their dictionary under
+    // them, so the new one is written next to it and renamed over it (which leaves their mappings intact)
+    std::string tempFile = file + ".tmp";
+    std::ofstream outfile(tempFile, std::ios::binary);
+    if (!outfile) {
+        return false;
+    }
+
+    FileHeader header;
+    memcpy(header.magic, MAGIC, sizeof(MAGIC));
+    header.byteOrder = BYTE_ORDER_MARK;
+    header.numCells = m_numCells;
+    outfile.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    outfile.write(reinterpret_cast<const char*>(m_data), (std::streamsize) m_numCells * sizeof(Cell));
+    outfile.close();
+    bool ok = static_cast<bool>(outfile);
+
+#ifdef _WIN32
+    // Windows won't rename over an existing file
+    if (ok) {
+        std::remove(file.c_str());
+    }
+#endif
+    if (!ok || std::rename(tempFile.c_str(), file.c_str()) != 0) {
+        std::remove(tempFile.c_str());
+        return false;
+    }
+
+    return true;
+}
+
+// Time Complexity: O(1), since nothing is read until a lookup touches it
+bool DoubleArrayTrie::open(const std::string& file) {
+    std::unique_ptr<MappedFile> mapped(new MappedFile);
+    if (!mapped->map(file) || mapped->size() < sizeof(FileHeader)) {
+        return false;
+    }
+
+    FileHeader header;
+    memcpy(&header, mapped->data(), sizeof(header));
+    if (memcmp(header.magic, MAGIC, sizeof(MAGIC)) != 0 || header.byteOrder != BYTE_ORDER_MARK
+        || header.numCells < 1 + NUM_CODES
+        || mapped->size() != sizeof(FileHeader) + (size_t) header.numCells * sizeof(Cell)) {
+        return false;
+    }
+
+    // The header is a multiple of 4 bytes long and the mapping starts on a page, so the cells are aligned
+    m_file = std::move(mapped);
+    m_cells.clear();
+    m_cells.shrink_to_fit();
+    m_data = reinterpret_cast<const Cell*>(m_file->data() + sizeof(FileHeader));
+    m_numCells = header.numCells;
+    return true;
+}
+
+void DoubleArrayTrie::listWords(std::vector<std::string>& words) const {
+    words.clear();
+    std::string prefix;
+    listWords(ROOT, prefix, words);
+}
+
+bool DoubleArrayTrie::contains(std::string_view word) const {
+    int state = ROOT;
+    for (char ch : word) {
+        int code = CODE_TABLE.codes[(unsigned char) ch];
+        if (code == NO_CODE) {
+            return false;
+        }
+
+        // A cell outside the array (which only a damaged file could lead to) is no child of anything
+        unsigned int next = (unsigned int) m_data[state].base + code;
+        if (next >= (unsigned int) m_numCells || m_data[next].check != state) {
+            return false;
+        }
+        state = next;
+    }
+
+    return endsWord(state);
+}
+
+uint32_t DoubleArrayTrie::childCodes(int state) const {
+    // The children's cells are next to each other, so this is a scan of a few cache lines, which has no
+    // branches to mispredict unless the cells run past the end of the array
+    uint32_t codes = 0;
+    unsigned int base = m_data[state].base;
+    if (base + NUM_CODES <= (unsigned int) m_numCells) {
+        for (int code = 1; code < NUM_CODES; code++) {
+            codes |= (uint32_t) (m_data[base + code].check == state) << code;
+        }
+        return codes;
+    }
+    for (int code = 1; code < NUM_CODES; code++) {
+        unsigned int next = base + code;
+        if (next < (unsigned int) m_numCells && m_data[next].check == state) {
+            codes |= 1u << code;
+        }
+    }
+    return codes;
+}
+
+size_t DoubleArrayTrie::memoryUsage() const {
+    return m_cells.capacity() * sizeof(Cell);
+}
+
+int DoubleArrayTrie::code(char ch) {
+    return CODE_TABLE.codes[(unsigned char) ch];
+}
+
+char DoubleArrayTrie::character(int code) {
+    return code == APOSTROPHE ? '\'' : 'a' + code - 1;
+}
+
+void DoubleArrayTrie::buildState(int state, const std::vector<std::string>& words, int first, int last, int depth) {
+    // The words are sorted and share their first depth characters, so the words that continue with each
+    // character are a contiguous run of them; a word that ends here comes first
+    int codes[NUM_CODES];
+    int starts[NUM_CODES + 1];
+    int numCodes = 0;
+    int i = first;
+    if (i < last && (int) words[i].length() == depth) {
+        codes[numCodes] = END;
+        starts[numCodes] = i;
+        numCodes++;
+        i++;
+    }
+    while (i < last) {
+        int code = CODE_TABLE.codes[(unsigned char) words[i][depth]];
+        codes[numCodes] = code;
+        starts[numCodes] = i;
+        numCodes++;
+        while (i < last && CODE_TABLE.codes[(unsigned char) words[i][depth]] == code) {
+            i++;
+        }
+    }
+    starts[numCodes] = last;
+
+    if (numCodes == 0) {
+        return;
+    }
+
+    // Claim every child's cell before building any of them, so they can't take each other's cells
+    int base = findBase(codes, numCodes);
+    m_cells[state].base = base;
+    for (int j = 0; j < numCodes; j++) {
+        m_cells[base + codes[j]].check = state;
+    }
+
+    for (int j = 0; j < numCodes; j++) {
+        if (codes[j] != END) {
+            buildState(base + codes[j], words, starts[j], starts[j + 1], depth + 1);
+        }
+    }
+}
+
+int DoubleArrayTrie::findBase(const int* codes, int numCodes) {
+    int numOccupied = 0;
+    int cell = std::max(m_nextFree, codes[0] + 1);
+    for (;; cell++) {
+        // Make sure every cell the base could put a child in exists
+        if (cell + NUM_CODES >= (int) m_cells.size()) {
+            Cell free;
+            free.base = 0;
+            free.check = EMPTY;
+            m_cells.resize(std::max(2 * m_cells.size(), (size_t) cell + NUM_CODES + 1), free);
+        }
+
+        if (m_cells[cell].check != EMPTY) {
+            numOccupied++;
+            continue;
+        }
+
+        // Try lining the first child up with this free cell
+        int base = cell - codes[0];
+        bool fits = true;
+        for (int j = 1; j < numCodes && fits; j++) {
+            fits = m_cells[base + codes[j]].check == EMPTY;
+        }
+        if (fits) {
+            break;
+        }
+    }
+
+    // Once nearly every cell looked at was taken, later states start looking after them instead
+    if (numOccupied >= 0.95 * (cell - m_nextFree + 1)) {
+        m_nextFree = cell;
+    }
+
+    return cell - codes[0];
+}
+
+void DoubleArrayTrie::listWords(int state, std::string& prefix, std::vector<std::string>& words) const {
+    if (endsWord(state)) {
+        words.push_back(prefix);
+    }
+
+    for (int code = 1; code < NUM_CODES; code++) {
+        int next = child(state, code);
+        if (next >= 0) {
+            prefix += character(code);
+            listWords(next, prefix, words);
+            prefix.pop_back();
+        }
+    }
+}
\ No newline at end of file
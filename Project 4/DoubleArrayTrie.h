@@ -0,0 +1,122 @@
+#ifndef DOUBLEARRAYTRIE_H_
+#define DOUBLEARRAYTRIE_H_
+
+#include "MappedFile.h"
+
+#include <string>
+#include <string_view>
+#include <vector>
+#include <memory>
+#include <cstddef>
+#include <cstdint>
+#ifdef _MSC_VER
+#include <xmmintrin.h>
+#endif
+
+// A trie of words made of letters and apostrophes, stored as a double array: every state is a cell of one
+// contiguous array, holding a base and a check. The child of state s on character code c is the cell at
+// base[s] + c, and it really is s's child only if its check is s. So following a character is two array
+// reads rather than a pointer chase, and the whole trie is 8 bytes per state with no per-node allocations.
+// A word ending at a state is a transition on code END, so it costs a cell like any other character.
+// Letters are mapped to codes through a table rather than by tolower and a branch, and either case of a
+// letter gets the same code, so lookups are case-insensitive.
+// Since states refer to each other by index, the array can be written to a file exactly as it is in memory and
+// mapped straight back in, with no parsing or building, and every process mapping it shares the same pages.
+class DoubleArrayTrie {
+public:
+    // Character codes: END marks the end of a word, then 'a' through 'z', then the apostrophe
+    static const int END = 0;
+    static const int APOSTROPHE = 27;
+    static const int NUM_CODES = 28;
+    // The code of a character that can't be in a word
+    static const int NO_CODE = -1;
+    // The state every word starts from
+    static const int ROOT = 0;
+
+    DoubleArrayTrie();
+
+    // Replace the contents of the trie with words, which may only hold characters that have codes
+    // words is lowercased, sorted and has its duplicates removed along the way
+    void build(std::vector<std::string>& words);
+    // Write the trie to a file that open can map, returning false if it can't be written
+    bool save(const std::string& file) const;
+    // Replace the contents of the trie with a file written by save, mapped read-only rather than read, in O(1) time
+    // Returns false (leaving the trie alone) if the file can't be opened or wasn't written by save on this platform
+    // A damaged file can only make lookups give wrong answers, since they never follow an index out of the array
+    bool open(const std::string& file);
+    // Fill words with every word in the trie, in lowercase and in order of their codes
+    void listWords(std::vector<std::string>& words) const;
+    // Return whether word is in the trie, ignoring case
+    // Time Complexity: O(L) for a word of length L, with no allocations
+    bool contains(std::string_view word) const;
+    // Return the state reached by following code from state, or -1 if there isn't one
+    // (this and the other lookups the search for suggestions makes thousands of times are defined below,
+    // so that they're inlined into it)
+    int child(int state, int code) const;
+    // Return a bit mask with bit c set for every code c that state has a child on
+    uint32_t childCodes(int state) const;
+    // Return whether a word ends at state
+    bool endsWord(int state) const;
+    // Start loading what following any of codes (a bit mask like childCodes's) from state reads into the cache,
+    // without waiting for it
+    void prefetch(int state, uint32_t codes) const;
+    // Return how many bytes the trie takes up
+    size_t memoryUsage() const;
+
+    // Return the code of ch, or NO_CODE if it can't be in a word
+    static int code(char ch);
+    // Return the lowercase character with a given code (other than END)
+    static char character(int code);
+private:
+    // One state of the trie, or a free cell if check is EMPTY
+    struct Cell {
+        int base;   // Where the cells of the state's children start
+        int check;  // The state's parent
+    };
+    static const int EMPTY = -1;
+    // What a file written by save starts with; the cells follow it
+    struct FileHeader {
+        char magic[8];
+        int byteOrder;  // Tells whether the file was written on a machine with the same byte order
+        int numCells;
+    };
+
+    std::vector<Cell> m_cells;      // The cells, unless they're in m_file
+    std::unique_ptr<MappedFile> m_file;     // The file the cells are mapped from, if they are
+    const Cell* m_data;     // Wherever the cells are
+    int m_numCells;
+    int m_nextFree;     // Where finding a base for the next state's children starts looking (only while building)
+
+    // Give state the children that words[first, last) continue with after their first depth characters,
+    // then do the same for each of the children
+    void buildState(int state, const std::vector<std::string>& words, int first, int last, int depth);
+    // Find a base at which every one of codes lands on a free cell, growing the array if needed
+    int findBase(const int* codes, int numCodes);
+    // Add every word starting with prefix, which ends at state, to words
+    void listWords(int state, std::string& prefix, std::vector<std::string>& words) const;
+};
+
+inline int DoubleArrayTrie::child(int state, int code) const {
+    unsigned int next = (unsigned int) m_data[state].base + code;
+    return next < (unsigned int) m_numCells && m_data[next].check == state ? next : -1;
+}
+
+inline bool DoubleArrayTrie::endsWord(int state) const {
+    unsigned int end = (unsigned int) m_data[state].base + END;
+    return end < (unsigned int) m_numCells && m_data[end].check == state;
+}
+
+inline void DoubleArrayTrie::prefetch(int state, uint32_t codes) const {
+    unsigned int base = m_data[state].base;
+    for (int code = 0; codes != 0; code++, codes >>= 1) {
+        if ((codes & 1) && base + code < (unsigned int) m_numCells) {
+#ifdef _MSC_VER
+            _mm_prefetch((const char*) &m_data[base + code], _MM_HINT_T0);
+#else
+            __builtin_prefetch(&m_data[base + code]);
+#endif
+        }
+    }
+}
+
+#endif // DOUBLEARRAYTRIE_H_
\ No newline at end of file
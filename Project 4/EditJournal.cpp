@@ -0,0 +1,289 @@
+#include "EditJournal.h"
+#include <string>
+#include <string_view>
+#include <vector>
+#include <fstream>
+#include <iterator>
+#include <filesystem>
+#include <chrono>
+#include <cstring>
+
+#ifndef _WIN32
+#include <unistd.h>
+#endif
+
+// Records are committed once this many bytes have built up, or once this much time has passed, whichever comes first
+const size_t COMMIT_SIZE = 1 << 16;
+const std::chrono::milliseconds COMMIT_INTERVAL(50);
+
+// A journal starts with a header identifying the version of the file its edits were made to
+const char MAGIC[8] = { 'E', 'D', 'J', 'O', 'U', 'R', 'N', '1' };
+struct Header {
+    char magic[8];
+    long long size;         // Size of the file the edits apply to
+    long long modified;     // When that file was last written
+};
+
+// Every record has the same size, except that TEXT, QUERY, REPLACE, and CURSORS records are followed by value bytes of text
+struct Record {
+    int command;
+    int row;
+    int col;
+    int value;
+};
+
+// Find out the size and modification time of a file, returning false if it doesn't exist
+static bool fileVersion(const std::string& file, long long& size, long long& modified) {
+    std::error_code error;
+    size = std::filesystem::file_size(file, error);
+    if (error) {
+        return false;
+    }
+    modified = std::filesystem::last_write_time(file, error).time_since_epoch().count();
+    return !error;
+}
+
+EditJournal::EditJournal() : m_file(nullptr), m_resume(false), m_stopping(false) {}
+
+EditJournal::~EditJournal() {
+    // Whatever was recorded stays on the disk; only discard() deletes it
+    close();
+}
+
+std::string EditJournal::journalFile(const std::string& file) {
+    return file + ".journal";
+}
+
+bool EditJournal::recover(const std::string& file, std::vector<Entry>& entries) {
+    entries.clear();
+    m_recoveredPath.clear();
+    m_recoveredEnds.clear();
+
+    std::string path = journalFile(file);
+    std::ifstream infile(path, std::ios::binary);
+    if (!infile) {
+        return false;
+    }
+    std::string contents((std::istreambuf_iterator<char>(infile)), std::istreambuf_iterator<char>());
+
+    // The edits only make sense if the file is still exactly the way it was when they were made
+    Header header;
+    long long size, modified;
+    if (contents.length() < sizeof(Header) || !fileVersion(file, size, modified)) {
+        return false;
+    }
+    memcpy(&header, contents.data(), sizeof(Header));
+    if (memcmp(header.magic, MAGIC, sizeof(MAGIC)) != 0 || header.size != size || header.modified != modified) {
+        return false;
+    }
+
+    // A crash can leave the last record half written, so stop at the first one that doesn't fit or doesn't make sense
+    size_t pos = sizeof(Header);
+    while (pos + sizeof(Record) <= contents.length()) {
+        Record record;
+        memcpy(&record, contents.data() + pos, sizeof(Record));
+        if (record.command < INSERT || record.command > MULTI_BACKSPACE) {
+            break;
+        }
+
+        size_t end = pos + sizeof(Record);
+        Entry entry;
+        entry.command = static_cast<Command>(record.command);
+        entry.row = record.row;
+        entry.col = record.col;
+        entry.value = record.value;
+
+        if (entry.command == TEXT || entry.command == QUERY || entry.command == REPLACE || entry.command == CURSORS) {
+            if (record.value < 0 || (size_t) record.value > contents.length() - end) {
+                break;
+            }
+            entry.text.assign(contents, end, record.value);
+            end += record.value;
+        }
+
+        entries.push_back(std::move(entry));
+        m_recoveredEnds.push_back(end);
+        pos = end;
+    }
+
+    m_recoveredPath = path;
+    return !entries.empty();
+}
+
+bool EditJournal::open(const std::string& file, int numKept) {
+    close();
+
+    std::string path = journalFile(file);
+    long keptLength = 0;
+    if (numKept > 0 && path == m_recoveredPath && numKept <= (int) m_recoveredEnds.size()) {
+        keptLength = m_recoveredEnds[numKept - 1];
+    }
+    m_recoveredPath.clear();
+    m_recoveredEnds.clear();
+
+    m_resume = false;
+    if (keptLength > 0) {
+        // Cut off whatever comes after the kept records, so new records follow straight after them
+        std::error_code error;
+        std::filesystem::resize_file(path, keptLength, error);
+        m_resume = !error;
+    }
+
+    // A new journal is for the file as it is now, not as it is when the first edit comes along
+    Header header;
+    memcpy(header.magic, MAGIC, sizeof(MAGIC));
+    if (!fileVersion(file, header.size, header.modified)) {
+        return false;
+    }
+    m_header.assign(reinterpret_cast<const char*>(&header), sizeof(Header));
+
+    m_path = path;
+    return true;
+}
+
+bool EditJournal::start() {
+    if (m_path.empty()) {
+        return false;
+    }
+
+    if (m_resume) {
+        m_file = std::fopen(m_path.c_str(), "ab");
+    }
+    if (m_file == nullptr) {
+        m_file = std::fopen(m_path.c_str(), "wb");
+        if (m_file == nullptr) {
+            // Recording stops here rather than trying again on every keystroke
+            m_path.clear();
+            return false;
+        }
+        m_pending = m_header;
+    }
+    // Commits write whole batches at once, so the stream's own buffer would just be an extra copy
+    std::setvbuf(m_file, nullptr, _IONBF, 0);
+
+    m_stopping = false;
+    m_committer = std::thread(&EditJournal::commitLoop, this);
+    return true;
+}
+
+void EditJournal::discard() {
+    if (m_path.empty()) {
+        return;
+    }
+
+    // There's no point in writing out records for a journal that's about to be deleted
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_pending.clear();
+    }
+
+    std::string path = m_path;
+    close();
+    std::remove(path.c_str());
+}
+
+void EditJournal::append(Command command, int row, int col, int value) {
+    if (m_file != nullptr || start()) {
+        appendRecord(command, row, col, value, std::string_view());
+    }
+}
+
+void EditJournal::appendText(int row, int col, std::string_view text) {
+    if (m_file != nullptr || start()) {
+        appendRecord(TEXT, row, col, text.length(), text);
+    }
+}
+
+void EditJournal::appendReplace(int row, int col, std::string_view query, std::string_view replacement) {
+    if (m_file != nullptr || start()) {
+        appendRecord(QUERY, row, col, query.length(), query);
+        appendRecord(REPLACE, row, col, replacement.length(), replacement);
+    }
+}
+
+void EditJournal::appendCursors(int row, int col, std::string_view cursors) {
+    if (m_file != nullptr || start()) {
+        appendRecord(CURSORS, row, col, cursors.length(), cursors);
+    }
+}
+
+bool EditJournal::commit() {
+    // Nothing has been appended to a journal that has no file yet
+    if (m_file == nullptr) {
+        return !m_path.empty();
+    }
+
+    // Take everything that's built up so far, so the editor can keep appending while it's being written
+    std::lock_guard<std::mutex> commitLock(m_commitMutex);
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_batch.clear();
+        m_batch.swap(m_pending);
+    }
+    if (m_batch.empty()) {
+        return true;
+    }
+
+    // One write and one sync cover every record in the batch
+    bool ok = std::fwrite(m_batch.data(), 1, m_batch.length(), m_file) == m_batch.length();
+    ok = ok && std::fflush(m_file) == 0;
+#ifndef _WIN32
+    ok = ok && fsync(fileno(m_file)) == 0;
+#endif
+
+    return ok;
+}
+
+// Time Complexity: O(1) amortized, since all it does is copy the record onto the end of a buffer
+void EditJournal::appendRecord(Command command, int row, int col, int value, std::string_view text) {
+    Record record;
+    record.command = command;
+    record.row = row;
+    record.col = col;
+    record.value = value;
+
+    bool full;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_pending.append(reinterpret_cast<const char*>(&record), sizeof(Record));
+        m_pending.append(text.data(), text.length());
+        full = m_pending.length() >= COMMIT_SIZE;
+    }
+
+    if (full) {
+        m_wake.notify_one();
+    }
+}
+
+void EditJournal::commitLoop() {
+    std::unique_lock<std::mutex> lock(m_mutex);
+    while (!m_stopping) {
+        m_wake.wait_for(lock, COMMIT_INTERVAL, [this] { return m_stopping || m_pending.length() >= COMMIT_SIZE; });
+
+        // close() commits whatever is left itself
+        if (!m_stopping && !m_pending.empty()) {
+            lock.unlock();
+            commit();
+            lock.lock();
+        }
+    }
+}
+
+void EditJournal::close() {
+    if (m_file == nullptr) {
+        m_path.clear();
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stopping = true;
+    }
+    m_wake.notify_one();
+    m_committer.join();
+
+    commit();
+    std::fclose(m_file);
+    m_file = nullptr;
+    m_path.clear();
+}
\ No newline at end of file
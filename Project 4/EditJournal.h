@@ -0,0 +1,92 @@
+#ifndef EDITJOURNAL_H_
+#define EDITJOURNAL_H_
+
+#include <string>
+#include <string_view>
+#include <vector>
+#include <cstdio>
+#include <mutex>
+#include <condition_variable>
+#include <thread>
+
+// An append-only log of every edit made to a document since it last matched its file on disk, kept next to
+// that file so the edits can be replayed if the editor dies before they're saved. Appending an edit only copies
+// it into a buffer in memory; a background thread writes out whatever has built up and syncs it to the disk all
+// at once (a group commit), so a keystroke never has to wait for the disk.
+// The journal's file and thread are only created once the first edit is recorded, so a document that's opened
+// and never edited costs nothing.
+class EditJournal {
+public:
+    // The editor commands that are recorded; replaying them through the editor rebuilds its undo history too
+    // A replace-all is recorded as a QUERY command followed by a REPLACE command with the replacement,
+    // and a multi-cursor edit as a CURSORS command with the extra cursors followed by one of the MULTI commands
+    enum Command { INSERT, DELETE, BACKSPACE, ENTER, TEXT, UNDO, REDO, QUERY, REPLACE,
+                   CURSORS, MULTI_INSERT, MULTI_DELETE, MULTI_BACKSPACE };
+
+    struct Entry {
+        Command command;
+        int row;            // Where the cursor was when the command was given
+        int col;
+        int value;          // The character that was inserted, the number of operations undone, or the branch redone
+        // The text that was inserted by a TEXT command, the query or replacement, or the packed cursors
+        std::string text;
+    };
+
+    EditJournal();
+    ~EditJournal();
+
+    // Return the name of the journal that's kept for file
+    static std::string journalFile(const std::string& file);
+
+    // Read back the edits that were recorded for file by a session that ended without saving them
+    // Nothing is returned if file has changed since they were recorded, and reading stops at the first
+    // record that was only partly written
+    bool recover(const std::string& file, std::vector<Entry>& entries);
+    // Start recording the edits made to file, keeping the first numKept entries that recover() just found for it
+    // Returns false if file doesn't exist; the journal's file isn't touched until the first edit is recorded,
+    // except to cut off any records after the kept ones
+    bool open(const std::string& file, int numKept = 0);
+    // Stop recording and delete the journal, because its edits have been saved or thrown away
+    void discard();
+
+    // Record a command given at row, col (these do nothing unless the journal is open)
+    void append(Command command, int row, int col, int value = 0);
+    void appendText(int row, int col, std::string_view text);
+    void appendReplace(int row, int col, std::string_view query, std::string_view replacement);
+    void appendCursors(int row, int col, std::string_view cursors);
+    // Write out everything appended so far and wait until it's on the disk, returning false if that fails
+    bool commit();
+private:
+    std::string m_path;         // The journal's file name, or empty if it isn't open
+    std::FILE* m_file;          // Null until the first record is appended
+    std::string m_header;       // What the file starts with if it's new: the version of the document it was opened for
+    bool m_resume;              // Whether new records go after the ones kept in the file rather than in a new one
+
+    std::string m_pending;      // Records appended since the last commit
+    std::string m_batch;        // Records being written by the current commit
+    std::mutex m_mutex;         // Guards m_pending and m_stopping
+    std::mutex m_commitMutex;   // Held while committing, so only one commit writes to m_file at a time
+    std::condition_variable m_wake;
+    std::thread m_committer;
+    bool m_stopping;
+
+    // Where each record that recover() found ends, so open() can keep some of them
+    std::string m_recoveredPath;
+    std::vector<long> m_recoveredEnds;
+
+    // A journal belongs to one file and can't be copied
+    EditJournal(const EditJournal&);
+    EditJournal& operator=(const EditJournal&);
+
+    // Create the journal's file and start the committer if nothing has been appended since it was opened,
+    // returning whether the journal is recording
+    bool start();
+    // Add one record to m_pending, waking the committer early if a lot has built up
+    void appendRecord(Command command, int row, int col, int value, std::string_view text);
+    // Commit every so often until the journal is closed (run by m_committer)
+    void commitLoop();
+    // Stop the committer, commit what's left, and close the file
+    void close();
+};
+
+#endif // EDITJOURNAL_H_
\ No newline at end of file
@@ -0,0 +1,79 @@
+#include "GapBuffer.h"
+#include <string_view>
+#include <vector>
+#include <cstring>
+
+GapBuffer::GapBuffer() : m_gapStart(0), m_gapEnd(0) {}
+
+void GapBuffer::assign(std::string_view text) {
+    // Leave some room after the text so the first few keystrokes don't have to grow the buffer
+    m_buffer.resize(text.length() + 64);
+    memcpy(m_buffer.data(), text.data(), text.length());
+    m_gapStart = text.length();
+    m_gapEnd = m_buffer.size();
+}
+
+int GapBuffer::length() const {
+    return m_buffer.size() - (m_gapEnd - m_gapStart);
+}
+
+char GapBuffer::at(int pos) const {
+    // Positions at or after the gap are shifted over by the gap's size
+    return pos < m_gapStart ? m_buffer[pos] : m_buffer[pos + (m_gapEnd - m_gapStart)];
+}
+
+void GapBuffer::insert(int pos, char ch) {
+    reserveGap(1);
+    moveGap(pos);
+    m_buffer[m_gapStart++] = ch;
+}
+
+void GapBuffer::insert(int pos, std::string_view text) {
+    reserveGap(text.length());
+    moveGap(pos);
+    memcpy(m_buffer.data() + m_gapStart, text.data(), text.length());
+    m_gapStart += text.length();
+}
+
+void GapBuffer::erase(int pos, int count) {
+    // Erasing is just widening the gap over the erased characters
+    moveGap(pos);
+    m_gapEnd += count;
+}
+
+LineView GapBuffer::view() const {
+    return LineView(std::string_view(m_buffer.data(), m_gapStart),
+                    std::string_view(m_buffer.data() + m_gapEnd, m_buffer.size() - m_gapEnd));
+}
+
+// Time Complexity: O(D) where D is the distance the gap moves
+void GapBuffer::moveGap(int pos) {
+    if (pos < m_gapStart) {
+        // Shift the characters between pos and the gap to the other side of the gap
+        int count = m_gapStart - pos;
+        memmove(m_buffer.data() + m_gapEnd - count, m_buffer.data() + pos, count);
+        m_gapStart -= count;
+        m_gapEnd -= count;
+    } else if (pos > m_gapStart) {
+        int count = pos - m_gapStart;
+        memmove(m_buffer.data() + m_gapStart, m_buffer.data() + m_gapEnd, count);
+        m_gapStart += count;
+        m_gapEnd += count;
+    }
+}
+
+void GapBuffer::reserveGap(int needed) {
+    int gapSize = m_gapEnd - m_gapStart;
+    if (gapSize >= needed) {
+        return;
+    }
+
+    // Grow geometrically so a long run of insertions costs O(1) amortized per character
+    int oldSize = m_buffer.size();
+    int newSize = oldSize * 2 > oldSize + needed - gapSize ? oldSize * 2 : oldSize + needed - gapSize + 64;
+    int tailLength = oldSize - m_gapEnd;
+
+    m_buffer.resize(newSize);
+    memmove(m_buffer.data() + newSize - tailLength, m_buffer.data() + m_gapEnd, tailLength);
+    m_gapEnd = newSize - tailLength;
+}
\ No newline at end of file
@@ -0,0 +1,41 @@
+#ifndef GAPBUFFER_H_
+#define GAPBUFFER_H_
+
+#include "LineView.h"
+
+#include <string_view>
+#include <vector>
+
+// A line of text stored with a gap of unused space at the editing position
+// Inserting or erasing at the gap only moves the gap's edges, so typing into the middle of a
+// long line costs O(1) amortized per keystroke instead of shifting the rest of the line over
+class GapBuffer {
+public:
+    GapBuffer();
+
+    // Replace the buffer's contents with text, leaving the gap at the end
+    void assign(std::string_view text);
+    // Return the number of characters in the buffer
+    int length() const;
+    // Return the character at a given position
+    char at(int pos) const;
+    // Insert characters so that the first one ends up at a given position
+    void insert(int pos, char ch);
+    void insert(int pos, std::string_view text);
+    // Erase count characters starting at a given position
+    void erase(int pos, int count);
+    // Return the buffer's contents as the text before the gap and the text after it (valid until the buffer
+    // is changed); reading never moves the gap, so it costs O(1) however far the gap is from the end
+    LineView view() const;
+private:
+    std::vector<char> m_buffer;
+    int m_gapStart;     // Position of the first unused character
+    int m_gapEnd;       // Position just after the last unused character
+
+    // Move the gap so that it starts at a given position
+    void moveGap(int pos);
+    // Make sure the gap can hold at least a given number of characters
+    void reserveGap(int needed);
+};
+
+#endif // GAPBUFFER_H_
\ No newline at end of file
@@ -0,0 +1,240 @@
+#include "LineDiff.h"
+#include "MappedFile.h"
+#include <string>
+#include <string_view>
+#include <vector>
+#include <algorithm>
+
+// Past this many inserted and deleted lines in one region, the rest of the region is reported as a single change
+// rather than spending O(D^2) memory to find the smallest diff
+const int MAX_EDITS = 1000;
+
+// Point views at count lines of lines starting at row, taking the line at activeRow from activeLine
+// Nothing is copied: the caller pins the lines of a compressed file in the cache while the region is diffed,
+// and the gap buffer stays put, so typing into a long line costs O(1) here unless its length stays the same
+static void viewLines(const LineRope& lines, int row, int count, int activeRow, const GapBuffer* activeLine,
+                      std::vector<LineView>& views) {
+    views.clear();
+    if (count == 0) {
+        return;
+    }
+
+    LineRope::Iterator it = lines.iterate(row);
+    for (int i = 0; i < count; i++, it.next()) {
+        views.push_back(row + i == activeRow ? activeLine->view() : LineView(it.view()));
+    }
+}
+
+LineDiff::LineDiff() : m_activeRow(-1), m_activeLine(nullptr) {}
+
+void LineDiff::reset(const LineRope& saved) {
+    m_saved = saved;
+    m_regions.clear();
+    m_changes.clear();
+}
+
+// Time Complexity: O(log R + R') for R regions, R' of which come after row
+void LineDiff::markChanged(int row, int count, int newCount) {
+    int end = row + count;
+
+    // Every region that overlaps or touches the changed rows gets merged with them into one region
+    std::vector<Region>::iterator first = std::lower_bound(m_regions.begin(), m_regions.end(), row,
+        [](const Region& region, int row) { return region.row + region.count < row; });
+    std::vector<Region>::iterator last = first;
+    while (last != m_regions.end() && last->row <= end) {
+        last++;
+    }
+
+    // Rows between regions line up with rows of the saved version, offset by however many rows the regions
+    // before them added or removed
+    int offset = 0;
+    if (first != m_regions.begin()) {
+        std::vector<Region>::iterator before = first - 1;
+        offset = before->savedRow + before->savedCount - (before->row + before->count);
+    }
+
+    Region merged;
+    merged.row = row;
+    merged.savedRow = row + offset;
+    int mergedEnd = end;
+    int savedEnd = end + offset;
+    if (first != last) {
+        if (first->row < row) {
+            merged.row = first->row;
+            merged.savedRow = first->savedRow;
+        }
+
+        std::vector<Region>::iterator back = last - 1;
+        if (back->row + back->count > end) {
+            mergedEnd = back->row + back->count;
+            savedEnd = back->savedRow + back->savedCount;
+        } else {
+            savedEnd = end + back->savedRow + back->savedCount - (back->row + back->count);
+        }
+    }
+    merged.count = mergedEnd - merged.row + newCount - count;
+    merged.savedCount = savedEnd - merged.savedRow;
+    merged.stale = true;
+
+    std::vector<Region>::iterator it = m_regions.erase(first, last);
+    it = m_regions.insert(it, merged);
+
+    // Everything after the change moves by however many rows it added or removed
+    if (newCount != count) {
+        for (it++; it != m_regions.end(); it++) {
+            it->row += newCount - count;
+        }
+    }
+}
+
+void LineDiff::setActiveLine(int row, const GapBuffer* line) {
+    m_activeRow = row;
+    m_activeLine = line;
+}
+
+const std::vector<LineDiff::Change>& LineDiff::changes(const LineRope& lines) {
+    m_changes.clear();
+
+    std::vector<LineView> saved;
+    std::vector<LineView> current;
+    for (Region& region : m_regions) {
+        // Only regions that were edited since they were last diffed have to be diffed again
+        if (region.stale) {
+            // Views of compressed lines have to stay valid until the lines they're compared with have been read
+            MappedFile::Pin pin;
+            viewLines(m_saved, region.savedRow, region.savedCount, -1, nullptr, saved);
+            viewLines(lines, region.row, region.count, m_activeRow, m_activeLine, current);
+
+            region.changes.clear();
+            diffLines(saved, current, region.changes);
+            region.stale = false;
+        }
+
+        for (Change change : region.changes) {
+            change.row += region.row;
+            change.savedRow += region.savedRow;
+            m_changes.push_back(change);
+        }
+    }
+
+    return m_changes;
+}
+
+// Time Complexity: O((N + M) * D) for runs of N and M lines with D lines inserted or deleted between them
+void LineDiff::diffLines(const std::vector<LineView>& saved, const std::vector<LineView>& lines,
+                         std::vector<Change>& changes) {
+    // Lines that are the same at the start and end don't have to go through the full diff
+    int start = 0;
+    int savedEnd = saved.size();
+    int end = lines.size();
+    while (start < savedEnd && start < end && saved[start] == lines[start]) {
+        start++;
+    }
+    while (savedEnd > start && end > start && saved[savedEnd - 1] == lines[end - 1]) {
+        savedEnd--;
+        end--;
+    }
+
+    int n = savedEnd - start;
+    int m = end - start;
+    if (n == 0 && m == 0) {
+        return;
+    }
+
+    Change whole;
+    whole.row = start;
+    whole.count = m;
+    whole.savedRow = start;
+    whole.savedCount = n;
+    if (n == 0 || m == 0) {
+        changes.push_back(whole);
+        return;
+    }
+
+    // Myers' algorithm: with x counting saved lines and y counting lines of the document, find how far along
+    // each diagonal k = x - y a path with d insertions and deletions can get, for d = 0, 1, 2, ... until one
+    // reaches the end; matching lines are free moves along a diagonal
+    int offset = n + m + 1;
+    std::vector<int> furthest(2 * offset + 1, 0);
+    std::vector<std::vector<int>> trace;    // furthest for diagonals -d to d, for each d
+    bool done = false;
+    int d;
+    for (d = 0; d <= MAX_EDITS && !done; d++) {
+        for (int k = -d; k <= d; k += 2) {
+            // Either move down (inserting a line) from diagonal k + 1 or right (deleting one) from diagonal k - 1
+            int x;
+            if (k == -d || (k != d && furthest[offset + k - 1] < furthest[offset + k + 1])) {
+                x = furthest[offset + k + 1];
+            } else {
+                x = furthest[offset + k - 1] + 1;
+            }
+            int y = x - k;
+            while (x < n && y < m && saved[start + x] == lines[start + y]) {
+                x++;
+                y++;
+            }
+            furthest[offset + k] = x;
+
+            if (x >= n && y >= m) {
+                done = true;
+            }
+        }
+        trace.push_back(std::vector<int>(furthest.begin() + offset - d, furthest.begin() + offset + d + 1));
+    }
+
+    if (!done) {
+        changes.push_back(whole);
+        return;
+    }
+
+    // Walk back from the end, turning every stretch between runs of matching lines into a change
+    size_t numChanges = changes.size();
+    int x = n;
+    int y = m;
+    int changeEndX = n;
+    int changeEndY = m;
+    for (int e = trace.size() - 1; e >= 0; e--) {
+        int k = x - y;
+        int startX = 0;     // Where the run of matching lines that ends at x, y starts
+        int prevX = 0;
+        int prevY = 0;
+        if (e > 0) {
+            // Find which diagonal the path came from, the same way it was chosen going forward
+            const std::vector<int>& previous = trace[e - 1];
+            int prevK;
+            if (k == -e || (k != e && previous[k - 1 + e - 1] < previous[k + 1 + e - 1])) {
+                prevK = k + 1;
+            } else {
+                prevK = k - 1;
+            }
+            prevX = previous[prevK + e - 1];
+            prevY = prevX - prevK;
+            startX = prevK == k + 1 ? prevX : prevX + 1;
+        }
+
+        if (x > startX) {
+            if (x < changeEndX || y < changeEndY) {
+                Change change;
+                change.row = start + y;
+                change.count = changeEndY - y;
+                change.savedRow = start + x;
+                change.savedCount = changeEndX - x;
+                changes.push_back(change);
+            }
+            changeEndX = startX;
+            changeEndY = startX - k;
+        }
+        x = prevX;
+        y = prevY;
+    }
+    if (changeEndX > 0 || changeEndY > 0) {
+        Change change;
+        change.row = start;
+        change.count = changeEndY;
+        change.savedRow = start;
+        change.savedCount = changeEndX;
+        changes.push_back(change);
+    }
+
+    std::reverse(changes.begin() + numChanges, changes.end());
+}
\ No newline at end of file
@@ -0,0 +1,62 @@
+#ifndef LINEDIFF_H_
+#define LINEDIFF_H_
+
+#include "LineRope.h"
+#include "GapBuffer.h"
+#include "LineView.h"
+
+#include <string_view>
+#include <vector>
+
+// Tracks which lines of a document have changed since it was last loaded or saved, and diffs them against
+// that saved version for the gutter's "modified lines" markers.
+// Edits are reported as they happen, and build up a sorted list of dirty regions; every line outside of them
+// is known to be the same as a line of the saved version, so only the regions ever get diffed. A region is
+// diffed again only after it's been edited, so after one keystroke only the region it touched costs anything.
+// The saved version is kept as a copy of the rope, which shares every line that hasn't changed since.
+class LineDiff {
+public:
+    // A run of lines that's different in the document than in the saved version
+    struct Change {
+        int row;            // First row of the run in the document
+        int count;          // Number of rows in the document (0 if lines were only deleted)
+        int savedRow;       // First row of the run in the saved version
+        int savedCount;     // Number of rows in the saved version (0 if lines were only added)
+    };
+
+    LineDiff();
+
+    // Start over with saved as the saved version, and nothing changed
+    void reset(const LineRope& saved);
+    // Record that count rows starting at row were replaced by newCount rows
+    // (so an edit within a line is markChanged(row, 1, 1) and splitting a line is markChanged(row, 1, 2))
+    void markChanged(int row, int count, int newCount);
+    // Read the line at row from line instead of from the document, since that's where it's being typed into
+    // (a row of -1 means every line is read from the document); line has to stay alive until this is undone
+    void setActiveLine(int row, const GapBuffer* line);
+    // Return every change between lines and the saved version, in order
+    // The results stay valid until the next call; lines must be the document every change was marked in
+    const std::vector<Change>& changes(const LineRope& lines);
+private:
+    // Rows of the document that may differ from rows of the saved version, and the changes in them once diffed
+    struct Region {
+        int row;
+        int count;
+        int savedRow;
+        int savedCount;
+        bool stale;     // Whether it's changed since it was last diffed
+        std::vector<Change> changes;    // Its changes, with rows relative to the start of the region
+    };
+
+    LineRope m_saved;
+    std::vector<Region> m_regions;  // Sorted by row, and never touching each other
+    std::vector<Change> m_changes;
+    int m_activeRow;        // The row being typed into, or -1 if there isn't one
+    const GapBuffer* m_activeLine;  // Where the text of the row being typed into is
+
+    // Find the changes between two runs of lines, with rows relative to the start of each run
+    static void diffLines(const std::vector<LineView>& saved, const std::vector<LineView>& lines,
+                          std::vector<Change>& changes);
+};
+
+#endif // LINEDIFF_H_
\ No newline at end of file
@@ -0,0 +1,487 @@
+#include "LineRope.h"
+#include <string>
+#include <string_view>
+#include <memory>
+#include <atomic>
+
+LineRope::LineRope() : m_root(nullptr) {}
+
+LineRope::~LineRope() {
+    release(m_root);
+}
+
+LineRope::LineRope(const LineRope& other) : m_root(retain(other.m_root)), m_source(other.m_source) {}
+
+LineRope& LineRope::operator=(const LineRope& other) {
+    // Retain first in case other is this rope
+    Node* root = retain(other.m_root);
+    release(m_root);
+    m_root = root;
+    m_source = other.m_source;
+    return *this;
+}
+
+int LineRope::size() const {
+    return size(m_root);
+}
+
+std::string& LineRope::at(int row) {
+    return materialize(row)->line;
+}
+
+std::string_view LineRope::view(int row) const {
+    int offset;
+    Node* node = find(m_root, row, offset);
+
+    // Untouched lines are read straight out of the source file
+    if (node->start >= 0) {
+        return m_source->line(node->start + offset);
+    }
+    return node->line;
+}
+
+void LineRope::insert(int row, const std::string& line) {
+    // Make sure the new line doesn't land in the middle of a piece
+    if (row < size()) {
+        materialize(row);
+    }
+
+    Node* node = createNode(-1, 1);
+    node->line = line;
+    m_root = insertRecursively(m_root, row, node);
+}
+
+void LineRope::insertLines(int row, std::vector<std::string>& lines) {
+    if (lines.empty()) {
+        return;
+    }
+
+    // Cut the rope open at row and join the new lines in between the two halves
+    m_root = separateAt(m_root, row);
+    Node* left;
+    Node* right;
+    split(m_root, row, left, right);
+    m_root = concat(concat(left, build(lines, 0, lines.size())), right);
+}
+
+void LineRope::erase(int row) {
+    materialize(row);
+    m_root = eraseRecursively(m_root, row);
+}
+
+void LineRope::eraseLines(int row, int count) {
+    if (count <= 0) {
+        return;
+    }
+
+    // Cut out the lines to erase, then put the rest of the rope back together
+    m_root = separateAt(m_root, row);
+    m_root = separateAt(m_root, row + count);
+    Node* left;
+    Node* middle;
+    Node* right;
+    split(m_root, row, left, right);
+    split(right, count, middle, right);
+    release(middle);
+    m_root = concat(left, right);
+}
+
+void LineRope::pushBack(const std::string& line) {
+    insert(size(), line);
+}
+
+void LineRope::clear() {
+    release(m_root);
+    m_root = nullptr;
+    m_source.reset();
+}
+
+void LineRope::assign(std::shared_ptr<const MappedFile> source) {
+    clear();
+    m_source = source;
+
+    // The whole file starts off as one piece
+    if (source->lineCount() > 0) {
+        m_root = createNode(0, source->lineCount());
+    }
+}
+
+LineRope::Iterator LineRope::iterate(int row) const {
+    Iterator it;
+    it.m_rope = this;
+    it.m_depth = 0;
+    it.m_offset = 0;
+
+    // Walk down to the row, remembering every node we pass on its left since those come after it
+    Node* node = m_root;
+    while (node != nullptr) {
+        int leftSize = size(node->left);
+        if (row < leftSize) {
+            it.m_path[it.m_depth++] = node;
+            node = node->left;
+        } else if (row < leftSize + node->count) {
+            it.m_path[it.m_depth++] = node;
+            it.m_offset = row - leftSize;
+            break;
+        } else {
+            row -= leftSize + node->count;
+            node = node->right;
+        }
+    }
+
+    return it;
+}
+
+bool LineRope::Iterator::done() const {
+    return m_depth == 0;
+}
+
+std::string_view LineRope::Iterator::view() const {
+    Node* node = m_path[m_depth - 1];
+    if (node->start >= 0) {
+        return m_rope->m_source->line(node->start + m_offset);
+    }
+    return node->line;
+}
+
+void LineRope::Iterator::next() {
+    Node* node = m_path[m_depth - 1];
+
+    // Step through a piece one line at a time before leaving its node
+    if (m_offset + 1 < node->count) {
+        m_offset++;
+        return;
+    }
+
+    // The next node is the leftmost node of the right subtree, or else the closest ancestor still on the stack
+    m_depth--;
+    m_offset = 0;
+    for (Node* child = node->right; child != nullptr; child = child->left) {
+        m_path[m_depth++] = child;
+    }
+}
+
+LineRope::Node* LineRope::createNode(int start, int count) {
+    Node* node = new Node;
+    node->start = start;
+    node->count = count;
+    node->left = nullptr;
+    node->right = nullptr;
+    node->height = 1;
+    node->size = count;
+    node->references.store(1, std::memory_order_relaxed);
+    return node;
+}
+
+LineRope::Node* LineRope::retain(Node* node) {
+    if (node != nullptr) {
+        node->references.fetch_add(1, std::memory_order_relaxed);
+    }
+    return node;
+}
+
+void LineRope::release(Node* node) {
+    // Another rope (maybe on another thread) could be dropping its reference at the same time, so only
+    // whichever reference turns out to be the last one destroys the node
+    if (node != nullptr && node->references.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+        release(node->left);
+        release(node->right);
+        delete node;
+    }
+}
+
+// Time Complexity: O(1), plus the length of the node's line if it has to be copied
+LineRope::Node* LineRope::own(Node* node) {
+    if (node == nullptr || node->references.load(std::memory_order_acquire) == 1) {
+        return node;
+    }
+
+    // The copy shares the node's children, so only this one node is copied
+    Node* copy = new Node;
+    copy->line = node->line;
+    copy->start = node->start;
+    copy->count = node->count;
+    copy->left = retain(node->left);
+    copy->right = retain(node->right);
+    copy->height = node->height;
+    copy->size = node->size;
+    copy->references.store(1, std::memory_order_relaxed);
+
+    release(node);
+    return copy;
+}
+
+int LineRope::height(Node* node) {
+    return node == nullptr ? 0 : node->height;
+}
+
+int LineRope::size(Node* node) {
+    return node == nullptr ? 0 : node->size;
+}
+
+void LineRope::update(Node* node) {
+    int leftHeight = height(node->left);
+    int rightHeight = height(node->right);
+    node->height = (leftHeight > rightHeight ? leftHeight : rightHeight) + 1;
+    node->size = size(node->left) + size(node->right) + node->count;
+}
+
+LineRope::Node* LineRope::rotateLeft(Node* node) {
+    Node* newRoot = own(node->right);
+    node->right = newRoot->left;
+    newRoot->left = node;
+
+    // The old root is now below the new root, so it must be updated first
+    update(node);
+    update(newRoot);
+    return newRoot;
+}
+
+LineRope::Node* LineRope::rotateRight(Node* node) {
+    Node* newRoot = own(node->left);
+    node->left = newRoot->right;
+    newRoot->right = node;
+
+    update(node);
+    update(newRoot);
+    return newRoot;
+}
+
+LineRope::Node* LineRope::rebalance(Node* node) {
+    update(node);
+    int balance = height(node->left) - height(node->right);
+
+    if (balance > 1) {
+        // Left-right case: straighten the left child out first
+        if (height(node->left->left) < height(node->left->right)) {
+            node->left = rotateLeft(own(node->left));
+        }
+        return rotateRight(node);
+    } else if (balance < -1) {
+        // Right-left case: straighten the right child out first
+        if (height(node->right->right) < height(node->right->left)) {
+            node->right = rotateRight(own(node->right));
+        }
+        return rotateLeft(node);
+    }
+
+    return node;
+}
+
+// Returns the node holding a given row of a subtree
+// Time Complexity: O(log N) since the tree is balanced
+LineRope::Node* LineRope::find(Node* node, int row, int& offset) {
+    while (node != nullptr) {
+        int leftSize = size(node->left);
+        if (row < leftSize) {
+            node = node->left;
+        } else if (row < leftSize + node->count) {
+            offset = row - leftSize;
+            return node;
+        } else {
+            // Skip over the left subtree and this node
+            row -= leftSize + node->count;
+            node = node->right;
+        }
+    }
+
+    return nullptr;
+}
+
+LineRope::Node* LineRope::materialize(int row) {
+    // Even a line that's already its own node may be shared with a copy of the rope, so the
+    // whole path down to it has to be owned before the caller can change it
+    Node* line;
+    m_root = splitRecursively(m_root, row, line);
+    return line;
+}
+
+LineRope::Node* LineRope::splitRecursively(Node* node, int row, Node*& line) {
+    node = own(node);
+    int leftSize = size(node->left);
+    if (row < leftSize) {
+        node->left = splitRecursively(node->left, row, line);
+    } else if (row >= leftSize + node->count) {
+        node->right = splitRecursively(node->right, row - leftSize - node->count, line);
+    } else if (node->start < 0) {
+        // The line is already its own node, so nothing below it changes
+        line = node;
+        return node;
+    } else {
+        int offset = row - leftSize;
+        int start = node->start;
+        int count = node->count;
+
+        // Copy the line out of the source and have this node hold just that line
+        std::string_view text = m_source->line(start + offset);
+        node->line.assign(text.data(), text.length());
+        node->start = -1;
+        node->count = 1;
+
+        // The rest of the piece becomes the last node of the left subtree and the first node of the right one
+        if (offset > 0) {
+            node->left = insertRecursively(node->left, leftSize, createNode(start, offset));
+        }
+        if (offset + 1 < count) {
+            node->right = insertRecursively(node->right, 0, createNode(start + offset + 1, count - offset - 1));
+        }
+
+        line = node;
+    }
+
+    return rebalance(node);
+}
+
+LineRope::Node* LineRope::separateAt(Node* node, int row) {
+    if (node == nullptr) {
+        return nullptr;
+    }
+
+    int leftSize = size(node->left);
+    if (row < leftSize) {
+        node = own(node);
+        node->left = separateAt(node->left, row);
+    } else if (row > leftSize + node->count) {
+        node = own(node);
+        node->right = separateAt(node->right, row - leftSize - node->count);
+    } else if (row > leftSize && row < leftSize + node->count) {
+        // The row is in the middle of this piece, so its second half becomes a piece of its own
+        node = own(node);
+        int offset = row - leftSize;
+        node->right = insertRecursively(node->right, 0, createNode(node->start + offset, node->count - offset));
+        node->count = offset;
+    } else {
+        // The row is already at the edge of this node
+        return node;
+    }
+
+    return rebalance(node);
+}
+
+LineRope::Node* LineRope::build(std::vector<std::string>& lines, int first, int last) {
+    if (first >= last) {
+        return nullptr;
+    }
+
+    int mid = first + (last - first) / 2;
+    Node* node = createNode(-1, 1);
+    node->line.swap(lines[mid]);    // The caller's lines are moved into the rope rather than copied
+    node->left = build(lines, first, mid);
+    node->right = build(lines, mid + 1, last);
+    update(node);
+    return node;
+}
+
+// Time Complexity: O(|height(left) - height(right)|) since it only walks down the taller tree's spine
+LineRope::Node* LineRope::join(Node* left, Node* middle, Node* right) {
+    if (height(left) > height(right) + 1) {
+        left = own(left);
+        left->right = join(left->right, middle, right);
+        return rebalance(left);
+    }
+    if (height(right) > height(left) + 1) {
+        right = own(right);
+        right->left = join(left, middle, right->left);
+        return rebalance(right);
+    }
+
+    // The trees are close enough in height to hang off of the middle node directly
+    middle->left = left;
+    middle->right = right;
+    update(middle);
+    return middle;
+}
+
+LineRope::Node* LineRope::concat(Node* left, Node* right) {
+    if (left == nullptr) {
+        return right;
+    }
+    if (right == nullptr) {
+        return left;
+    }
+
+    Node* middle;
+    right = detachMin(right, middle);
+    return join(left, middle, right);
+}
+
+void LineRope::split(Node* node, int row, Node*& left, Node*& right) {
+    if (node == nullptr) {
+        left = nullptr;
+        right = nullptr;
+        return;
+    }
+
+    node = own(node);
+    int leftSize = size(node->left);
+    if (row <= leftSize) {
+        // This node and its right subtree all belong on the right side
+        Node* leftOfRight;
+        split(node->left, row, left, leftOfRight);
+        right = join(leftOfRight, node, node->right);
+    } else {
+        Node* rightOfLeft;
+        split(node->right, row - leftSize - node->count, rightOfLeft, right);
+        left = join(node->left, node, rightOfLeft);
+    }
+}
+
+LineRope::Node* LineRope::insertRecursively(Node* node, int row, Node* toInsert) {
+    if (node == nullptr) {
+        return toInsert;
+    }
+
+    node = own(node);
+    int leftSize = size(node->left);
+    if (row <= leftSize) {
+        node->left = insertRecursively(node->left, row, toInsert);
+    } else {
+        node->right = insertRecursively(node->right, row - leftSize - node->count, toInsert);
+    }
+
+    return rebalance(node);
+}
+
+LineRope::Node* LineRope::eraseRecursively(Node* node, int row) {
+    if (node == nullptr) {
+        return nullptr;
+    }
+
+    node = own(node);
+    int leftSize = size(node->left);
+    if (row < leftSize) {
+        node->left = eraseRecursively(node->left, row);
+    } else if (row > leftSize) {
+        node->right = eraseRecursively(node->right, row - leftSize - node->count);
+    } else {
+        // The node is owned, so its references to its children can simply be handed over
+        Node* left = node->left;
+        Node* right = node->right;
+        delete node;
+
+        // A node with at most one child is simply replaced by that child
+        if (right == nullptr) {
+            return left;
+        }
+
+        // Otherwise replace it by the first node of its right subtree
+        Node* min;
+        right = detachMin(right, min);
+        min->left = left;
+        min->right = right;
+        node = min;
+    }
+
+    return rebalance(node);
+}
+
+LineRope::Node* LineRope::detachMin(Node* node, Node*& min) {
+    node = own(node);
+    if (node->left == nullptr) {
+        min = node;
+        return node->right;
+    }
+
+    node->left = detachMin(node->left, min);
+    return rebalance(node);
+}
\ No newline at end of file
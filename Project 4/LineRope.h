@@ -0,0 +1,139 @@
+#ifndef LINEROPE_H_
+#define LINEROPE_H_
+
+#include "MappedFile.h"
+
+#include <string>
+#include <string_view>
+#include <vector>
+#include <memory>
+#include <atomic>
+
+// A rope of lines: a height-balanced (AVL) tree whose in-order traversal yields the lines of a document.
+// Every node stores the number of lines in its subtree, so a line can be found, inserted, or erased by its
+// row number in O(log N) time instead of walking a linked list from the cursor.
+//
+// A node either holds one editable line or a piece: a run of consecutive lines that are still untouched
+// in the file the rope was loaded from. Pieces are split apart only when one of their lines is edited,
+// so a freshly loaded file is a single node no matter how many lines it has.
+//
+// Ropes are persistent: copying one takes O(1) time because the copy shares every node with the original.
+// Nodes count how many parents (or ropes) point to them, and a rope only ever changes a node that nothing
+// else points to, copying any shared node on the path down to a change first. So each copy keeps seeing
+// exactly the lines it had when it was made, and other threads can read a copy while the original is edited.
+class LineRope {
+private:
+    struct Node;
+public:
+    // Walks the lines of a rope in order, starting from any row
+    // Finding the first row takes O(log N) time and every step after that takes O(1) amortized time
+    // An iterator is only valid until the rope is changed
+    class Iterator {
+    public:
+        // Return whether the iterator has walked past the last line
+        bool done() const;
+        // Return the text of the current line
+        std::string_view view() const;
+        // Move on to the next line
+        void next();
+    private:
+        friend class LineRope;
+        // The tallest a balanced tree of 2^31 lines can get is under 64 levels
+        static const int MAX_DEPTH = 64;
+
+        const LineRope* m_rope;
+        Node* m_path[MAX_DEPTH];    // Nodes still left to visit; the top one holds the current line
+        int m_depth;
+        int m_offset;               // Offset of the current line within the top node
+    };
+
+    LineRope();
+    ~LineRope();
+    // Make a copy that shares all of its nodes with other in O(1) time
+    LineRope(const LineRope& other);
+    LineRope& operator=(const LineRope& other);
+
+    // Return the number of lines in the rope
+    int size() const;
+    // Return a reference to the line at a given row, copying it out of the source file if needed
+    std::string& at(int row);
+    // Return the text of the line at a given row without copying it (valid until the rope is changed)
+    std::string_view view(int row) const;
+    // Insert a line so that it ends up at the given row
+    void insert(int row, const std::string& line);
+    // Insert many lines at once so that the first one ends up at the given row
+    // Time Complexity: O(K + log N) for K lines, since they're built into a balanced tree and then spliced in
+    void insertLines(int row, std::vector<std::string>& lines);
+    // Erase the line at the given row
+    void erase(int row);
+    // Erase count lines starting at the given row in O(K + log N) time
+    void eraseLines(int row, int count);
+    // Append a line to the end of the rope
+    void pushBack(const std::string& line);
+    // Erase every line in the rope
+    void clear();
+    // Replace the contents of the rope with every line of a file, without copying any of them
+    void assign(std::shared_ptr<const MappedFile> source);
+    // Return an iterator positioned at the given row
+    Iterator iterate(int row) const;
+private:
+    struct Node {
+        std::string line;   // The line's text (only used if this node isn't a piece)
+        int start;          // Index in m_source of the piece's first line, or -1 if this node holds a line
+        int count;          // Number of lines this node holds (1 unless it's a piece)
+        Node* left;
+        Node* right;
+        int height;     // Height of the subtree rooted at this node
+        int size;       // Number of lines in the subtree rooted at this node
+        std::atomic<int> references;    // Number of nodes and ropes pointing to this node
+    };
+    Node* m_root;
+    std::shared_ptr<const MappedFile> m_source;     // The file that pieces refer to
+
+    // Create a node holding count lines starting at a line of the source, or one line if start is -1
+    static Node* createNode(int start, int count);
+    // Add a reference to a node and return it
+    static Node* retain(Node* node);
+    // Drop a reference to a node, destroying it (and dropping its references to its children) if it was the last one
+    static void release(Node* node);
+    // Return a node that can be changed in place of a given one, copying it if anything else points to it
+    // The reference to the given node is handed over to the copy, so the result replaces it wherever it was
+    static Node* own(Node* node);
+    static int height(Node* node);
+    static int size(Node* node);
+    // Recompute an owned node's height and size from its children
+    static void update(Node* node);
+    // Rotate/rebalance an owned node, owning whichever children they move
+    static Node* rotateLeft(Node* node);
+    static Node* rotateRight(Node* node);
+    // Restore the AVL property at a node whose children are balanced
+    static Node* rebalance(Node* node);
+    // Find the node holding a given row of a subtree, and the row's offset within that node
+    static Node* find(Node* node, int row, int& offset);
+    // The functions below that take the root of a subtree take over the reference to it, own whatever nodes
+    // they change, and return the subtree's new root
+
+    // Turn the line at a given row into its own editable node, splitting its piece around it and
+    // owning every node on the way down to it
+    Node* materialize(int row);
+    // Recursive part of materialize, returning the new root of the subtree and storing the line's node in line
+    Node* splitRecursively(Node* node, int row, Node*& line);
+    // Make sure no piece spans across a given row and the row before it, returning the new root of the subtree
+    Node* separateAt(Node* node, int row);
+    // Build a balanced tree out of lines[first, last)
+    static Node* build(std::vector<std::string>& lines, int first, int last);
+    // Join two trees with a node in between them, where every line of left comes before every line of right
+    static Node* join(Node* left, Node* middle, Node* right);
+    // Join two trees without a node in between them
+    static Node* concat(Node* left, Node* right);
+    // Split a tree into the lines before row and the lines at and after row (row must not split a piece)
+    static void split(Node* node, int row, Node*& left, Node*& right);
+    // Insert/erase recursively, returning the new root of the subtree
+    // Insertion must happen at a row where no piece would be split
+    static Node* insertRecursively(Node* node, int row, Node* toInsert);
+    static Node* eraseRecursively(Node* node, int row);
+    // Detach the leftmost node of a subtree, storing it in min
+    static Node* detachMin(Node* node, Node*& min);
+};
+
+#endif // LINEROPE_H_
\ No newline at end of file
@@ -0,0 +1,35 @@
+#include "LineView.h"
+#include <string_view>
+#include <algorithm>
+
+LineView LineView::substr(size_t pos, size_t count) const {
+    if (pos >= first.length()) {
+        return LineView(second.substr(pos - first.length(), count));
+    }
+    if (count <= first.length() - pos) {
+        return LineView(first.substr(pos, count));
+    }
+    return LineView(first.substr(pos), second.substr(0, count - (first.length() - pos)));
+}
+
+// Time Complexity: O(1) if the lengths differ, and O(L) otherwise
+bool LineView::operator==(const LineView& other) const {
+    if (length() != other.length()) {
+        return false;
+    }
+
+    // The two splits cut the text into three runs, none of which is split in either view
+    size_t firstSplit = std::min(first.length(), other.first.length());
+    size_t secondSplit = std::max(first.length(), other.first.length());
+    return part(0, firstSplit) == other.part(0, firstSplit)
+        && part(firstSplit, secondSplit - firstSplit) == other.part(firstSplit, secondSplit - firstSplit)
+        && part(secondSplit, length() - secondSplit) == other.part(secondSplit, length() - secondSplit);
+}
+
+bool LineView::operator!=(const LineView& other) const {
+    return !(*this == other);
+}
+
+std::string_view LineView::part(size_t pos, size_t count) const {
+    return pos < first.length() ? first.substr(pos, count) : second.substr(pos - first.length(), count);
+}
\ No newline at end of file
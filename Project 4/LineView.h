@@ -0,0 +1,31 @@
+#ifndef LINEVIEW_H_
+#define LINEVIEW_H_
+
+#include <string_view>
+#include <cstddef>
+
+// A read-only view of a line's text, which may be in two parts. The line being typed into is held in a gap
+// buffer, and reading it in place leaves it split at the gap; making it contiguous would mean moving the gap
+// to the end and back again, which costs as much as the text after it on every keystroke.
+// Every other line is all in first, with second empty.
+struct LineView {
+    std::string_view first;
+    std::string_view second;
+
+    LineView() {}
+    LineView(std::string_view text) : first(text) {}
+    LineView(std::string_view first, std::string_view second) : first(first), second(second) {}
+
+    // Return the number of characters in the line
+    size_t length() const { return first.length() + second.length(); }
+    // Return the count characters starting at pos, which are in two parts if they straddle the split
+    LineView substr(size_t pos, size_t count) const;
+    // Return whether two views hold the same text, however each of them is split
+    bool operator==(const LineView& other) const;
+    bool operator!=(const LineView& other) const;
+private:
+    // Return the count characters starting at pos, which have to be all in first or all in second
+    std::string_view part(size_t pos, size_t count) const;
+};
+
+#endif // LINEVIEW_H_
\ No newline at end of file
@@ -0,0 +1,154 @@
+#include "LzCodec.h"
+#include <string>
+#include <string_view>
+#include <vector>
+#include <algorithm>
+#include <cstring>
+#include <cstdint>
+
+// Copies shorter than this aren't worth a sequence, and copies can't reach back further than a 2-byte distance
+const size_t MIN_MATCH = 4;
+const size_t MAX_DISTANCE = 65535;
+const int HASH_BITS = 14;
+
+static uint32_t read32(const char* data) {
+    uint32_t value;
+    memcpy(&value, data, sizeof(value));
+    return value;
+}
+
+static uint32_t hash(uint32_t value) {
+    return (value * 2654435761u) >> (32 - HASH_BITS);
+}
+
+// Append the part of a length that didn't fit in a token's 4 bits
+static void writeLength(size_t length, std::string& output) {
+    while (length >= 255) {
+        output += (char) 255;
+        length -= 255;
+    }
+    output += (char) length;
+}
+
+// Add the part of a length that didn't fit in a token's 4 bits to length, returning false if input runs out first
+static bool readLength(const unsigned char*& input, const unsigned char* end, size_t& length) {
+    unsigned char byte;
+    do {
+        if (input == end) {
+            return false;
+        }
+        byte = *input++;
+        length += byte;
+    } while (byte == 255);
+    return true;
+}
+
+// Append a sequence of numLiterals bytes of literals and, unless matchLength is 0, a copy from distance back
+static void writeSequence(const char* literals, size_t numLiterals, size_t distance, size_t matchLength,
+                          std::string& output) {
+    size_t extra = matchLength > 0 ? matchLength - MIN_MATCH : 0;
+    output += (char) ((std::min<size_t>(numLiterals, 15) << 4) | std::min<size_t>(extra, 15));
+    if (numLiterals >= 15) {
+        writeLength(numLiterals - 15, output);
+    }
+    output.append(literals, numLiterals);
+
+    if (matchLength > 0) {
+        output += (char) (distance & 0xff);
+        output += (char) (distance >> 8);
+        if (extra >= 15) {
+            writeLength(extra - 15, output);
+        }
+    }
+}
+
+// Time Complexity: O(N) for N bytes of input
+void LzCodec::compress(std::string_view input, std::string& output) {
+    const char* data = input.data();
+    size_t size = input.length();
+
+    // Where each (hashed) 4-byte string was last seen
+    std::vector<uint32_t> lastSeen(1 << HASH_BITS, 0);
+
+    size_t literalStart = 0;
+    size_t pos = 0;
+    while (pos + MIN_MATCH <= size) {
+        uint32_t next = read32(data + pos);
+        uint32_t& slot = lastSeen[hash(next)];
+        size_t candidate = slot;
+        slot = pos;
+
+        // Different strings can hash the same, so the candidate still has to be checked
+        if (candidate < pos && pos - candidate <= MAX_DISTANCE && read32(data + candidate) == next) {
+            size_t length = MIN_MATCH;
+            while (pos + length < size && data[candidate + length] == data[pos + length]) {
+                length++;
+            }
+
+            writeSequence(data + literalStart, pos - literalStart, pos - candidate, length, output);
+            pos += length;
+            literalStart = pos;
+        } else {
+            // Take bigger steps the longer nothing has matched, so data that won't compress goes by quickly
+            pos += 1 + ((pos - literalStart) >> 6);
+        }
+    }
+
+    writeSequence(data + literalStart, size - literalStart, 0, 0, output);
+}
+
+// Time Complexity: O(N) for N bytes of output
+bool LzCodec::decompress(std::string_view input, char* output, size_t size) {
+    const unsigned char* in = reinterpret_cast<const unsigned char*>(input.data());
+    const unsigned char* end = in + input.length();
+    char* out = output;
+    char* outEnd = output + size;
+
+    while (in < end) {
+        unsigned char token = *in++;
+
+        size_t numLiterals = token >> 4;
+        if (numLiterals == 15 && !readLength(in, end, numLiterals)) {
+            return false;
+        }
+        if (numLiterals > (size_t) (end - in) || numLiterals > (size_t) (outEnd - out)) {
+            return false;
+        }
+        memcpy(out, in, numLiterals);
+        in += numLiterals;
+        out += numLiterals;
+
+        // Only the last sequence has no copy after its literals
+        if (in == end) {
+            return out == outEnd;
+        }
+
+        if (end - in < 2) {
+            return false;
+        }
+        size_t distance = in[0] | (in[1] << 8);
+        in += 2;
+        size_t length = token & 15;
+        if (length == 15 && !readLength(in, end, length)) {
+            return false;
+        }
+        length += MIN_MATCH;
+        if (distance == 0 || distance > (size_t) (out - output) || length > (size_t) (outEnd - out)) {
+            return false;
+        }
+
+        // A copy can overlap what it's producing (a run of one character is a copy from 1 back), and then it
+        // has to go a byte at a time so each byte is written before it's read
+        const char* source = out - distance;
+        if (distance >= length) {
+            memcpy(out, source, length);
+        } else {
+            for (size_t i = 0; i < length; i++) {
+                out[i] = source[i];
+            }
+        }
+        out += length;
+    }
+
+    return false;
+}
\ No newline at end of file
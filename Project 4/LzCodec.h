@@ -0,0 +1,23 @@
+#ifndef LZCODEC_H_
+#define LZCODEC_H_
+
+#include <string>
+#include <string_view>
+#include <cstddef>
+
+// A small, fast LZ77 compressor in the style of LZ4, for keeping text in memory compressed.
+// Compressed data is a series of sequences, each a run of literal bytes followed by a copy of earlier output.
+// A sequence starts with a token byte whose high and low 4 bits are the literal length and the copy length
+// (less the minimum of 4); a length of 15 continues in the bytes after it, each adding up to 255. The literals
+// come next, then a 2-byte little-endian distance back to the copy's source. The last sequence has literals only.
+// Matches are found with a hash table of recent 4-byte strings rather than a search, so compressing costs
+// O(1) per byte, and decompressing is mostly memcpy.
+class LzCodec {
+public:
+    // Append the compressed form of input to output
+    static void compress(std::string_view input, std::string& output);
+    // Decompress input into exactly size bytes at output, returning false if input is corrupt or the wrong size
+    static bool decompress(std::string_view input, char* output, size_t size);
+};
+
+#endif // LZCODEC_H_
\ No newline at end of file
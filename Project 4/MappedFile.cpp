@@ -0,0 +1,285 @@
+#include "MappedFile.h"
+#include "LzCodec.h"
+#include <string>
+#include <string_view>
+#include <vector>
+#include <fstream>
+#include <iterator>
+#include <cstring>
+#include <algorithm>
+#include <atomic>
+#include <memory>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+// Compressed blocks hold whole lines and grow until they're at least this big
+const size_t BLOCK_SIZE = 1 << 16;
+
+// Every open file gets a new id, so a cache never mistakes a new file's blocks for a closed one's
+static std::atomic<unsigned long long> s_nextId(1);
+
+// How many times this thread has used its cache, which orders its entries from least to most recently used
+static thread_local unsigned long long s_numUses = 0;
+// How many Pins this thread has, and how many uses there had been when the outermost one was made;
+// entries used since then are pinned
+static thread_local int s_numPins = 0;
+static thread_local unsigned long long s_pinnedSince = 0;
+
+struct MappedFile::CachedBlock {
+    unsigned long long file;    // Id of the file the block is from, or 0 if this entry is unused
+    int block;
+    unsigned long long lastUsed;
+    std::string text;
+    std::vector<size_t> lineStarts;
+
+    CachedBlock() : file(0), block(-1), lastUsed(0) {}
+};
+
+// Drop the newline and carriage return that end a line, if they're there
+static std::string_view trimLine(const char* data, size_t start, size_t end) {
+    if (end > start && data[end - 1] == '\n') {
+        end--;
+    }
+    if (end > start && data[end - 1] == '\r') {
+        end--;
+    }
+
+    return std::string_view(data + start, end - start);
+}
+
+MappedFile::MappedFile() : m_data(nullptr), m_size(0), m_mapped(false), m_id(0) {}
+
+MappedFile::~MappedFile() {
+    close();
+}
+
+bool MappedFile::open(const std::string& file, bool compress) {
+    if (!map(file)) {
+        return false;
+    }
+
+    if (compress) {
+        compressBlocks();
+        release();
+    } else {
+        indexLines();
+    }
+    return true;
+}
+
+bool MappedFile::map(const std::string& file) {
+    close();
+
+#ifndef _WIN32
+    int fd = ::open(file.c_str(), O_RDONLY);
+    if (fd < 0) {
+        return false;
+    }
+
+    struct stat info;
+    if (fstat(fd, &info) == 0 && info.st_size > 0) {
+        void* data = mmap(nullptr, info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (data != MAP_FAILED) {
+            m_data = static_cast<const char*>(data);
+            m_size = info.st_size;
+            m_mapped = true;
+        }
+    }
+    ::close(fd);
+#endif
+
+    // Fall back to reading the whole file if it couldn't be mapped (or is empty)
+    if (!m_mapped) {
+        std::ifstream infile(file, std::ios::binary);
+        if (!infile) {
+            return false;
+        }
+        m_buffer.assign(std::istreambuf_iterator<char>(infile), std::istreambuf_iterator<char>());
+        m_data = m_buffer.data();
+        m_size = m_buffer.size();
+    }
+    return true;
+}
+
+const char* MappedFile::data() const {
+    return m_data;
+}
+
+size_t MappedFile::size() const {
+    return m_size;
+}
+
+int MappedFile::lineCount() const {
+    if (!m_blocks.empty()) {
+        return m_blocks.back().firstLine + m_blocks.back().numLines;
+    }
+    return m_lineStarts.size();
+}
+
+std::string_view MappedFile::line(int index) const {
+    if (m_blocks.empty()) {
+        size_t start = m_lineStarts[index];
+        size_t end = index + 1 < (int) m_lineStarts.size() ? m_lineStarts[index + 1] : m_size;
+        return trimLine(m_data, start, end);
+    }
+
+    // Find the last block starting at or before the line
+    std::vector<Block>::const_iterator block = std::upper_bound(m_blocks.begin(), m_blocks.end(), index,
+        [](int index, const Block& block) { return index < block.firstLine; }) - 1;
+    const CachedBlock& cached = cachedBlock(block - m_blocks.begin());
+
+    int offset = index - block->firstLine;
+    size_t start = cached.lineStarts[offset];
+    size_t end = offset + 1 < block->numLines ? cached.lineStarts[offset + 1] : cached.text.length();
+    return trimLine(cached.text.data(), start, end);
+}
+
+MappedFile::Pin::Pin() {
+    if (s_numPins++ == 0) {
+        s_pinnedSince = s_numUses;
+    }
+}
+
+MappedFile::Pin::~Pin() {
+    s_numPins--;
+}
+
+size_t MappedFile::memoryUsage() const {
+    return m_buffer.capacity() + m_lineStarts.capacity() * sizeof(size_t)
+        + m_blocks.capacity() * sizeof(Block) + m_compressed.capacity();
+}
+
+void MappedFile::close() {
+    release();
+    m_lineStarts.clear();
+    m_blocks.clear();
+    m_compressed.clear();
+    m_id = 0;
+}
+
+void MappedFile::release() {
+#ifndef _WIN32
+    if (m_mapped) {
+        munmap(const_cast<char*>(m_data), m_size);
+    }
+#endif
+    m_data = nullptr;
+    m_size = 0;
+    m_mapped = false;
+    m_buffer.clear();
+    m_buffer.shrink_to_fit();
+}
+
+// Time Complexity: O(B) where B is the size of the file, but memchr skips through
+// the bytes between newlines many at a time instead of comparing them one by one
+void MappedFile::indexLines() {
+    if (m_size == 0) {
+        return;
+    }
+
+    const char* end = m_data + m_size;
+    const char* lineStart = m_data;
+    while (lineStart < end) {
+        m_lineStarts.push_back(lineStart - m_data);
+
+        const char* newline = static_cast<const char*>(memchr(lineStart, '\n', end - lineStart));
+        if (newline == nullptr) {
+            break;
+        }
+        lineStart = newline + 1;
+    }
+}
+
+// Time Complexity: O(B) where B is the size of the file
+void MappedFile::compressBlocks() {
+    m_id = s_nextId++;
+
+    const char* end = m_data + m_size;
+    const char* blockStart = m_data;
+    int numLines = 0;
+    while (blockStart < end) {
+        // Take whole lines until the block is big enough
+        Block block;
+        block.firstLine = numLines;
+        block.numLines = 0;
+        const char* blockEnd = blockStart;
+        while (blockEnd < end && (size_t) (blockEnd - blockStart) < BLOCK_SIZE) {
+            const char* newline = static_cast<const char*>(memchr(blockEnd, '\n', end - blockEnd));
+            blockEnd = newline == nullptr ? end : newline + 1;
+            block.numLines++;
+        }
+
+        block.offset = m_compressed.length();
+        block.size = blockEnd - blockStart;
+        LzCodec::compress(std::string_view(blockStart, block.size), m_compressed);
+        block.compressedSize = m_compressed.length() - block.offset;
+        m_blocks.push_back(block);
+
+        numLines += block.numLines;
+        blockStart = blockEnd;
+    }
+
+    m_compressed.shrink_to_fit();
+    m_blocks.shrink_to_fit();
+}
+
+const MappedFile::CachedBlock& MappedFile::cachedBlock(int block) const {
+    // Each thread decompresses into its own cache, so reading lines never has to lock anything
+    // The entries are allocated one by one so the cache can grow without moving any of them
+    static thread_local std::vector<std::unique_ptr<CachedBlock>> cache;
+
+    for (const std::unique_ptr<CachedBlock>& cached : cache) {
+        if (cached->file == m_id && cached->block == block) {
+            cached->lastUsed = ++s_numUses;
+            return *cached;
+        }
+    }
+
+    // Once nothing is pinned, a cache that grew past CACHE_BLOCKS drops its least recently used entries
+    auto leastRecentlyUsed = [](const std::unique_ptr<CachedBlock>& a, const std::unique_ptr<CachedBlock>& b) {
+        return a->lastUsed < b->lastUsed;
+    };
+    while (s_numPins == 0 && cache.size() > CACHE_BLOCKS) {
+        cache.erase(std::min_element(cache.begin(), cache.end(), leastRecentlyUsed));
+    }
+
+    // Reuse the least recently used entry that isn't pinned, unless the cache has room for another one
+    CachedBlock* entry = nullptr;
+    for (const std::unique_ptr<CachedBlock>& cached : cache) {
+        bool pinned = s_numPins > 0 && cached->lastUsed > s_pinnedSince;
+        if (!pinned && (entry == nullptr || cached->lastUsed < entry->lastUsed)) {
+            entry = cached.get();
+        }
+    }
+    if (entry == nullptr || cache.size() < CACHE_BLOCKS) {
+        cache.push_back(std::unique_ptr<CachedBlock>(new CachedBlock));
+        entry = cache.back().get();
+    }
+
+    const Block& info = m_blocks[block];
+    entry->file = m_id;
+    entry->block = block;
+    entry->lastUsed = ++s_numUses;
+    entry->text.resize(info.size);
+    // The block was compressed by this object, so it can't be corrupt
+    LzCodec::decompress(std::string_view(m_compressed.data() + info.offset, info.compressedSize),
+                        &entry->text[0], info.size);
+
+    // Index the block's lines, the same way indexLines does for a whole file
+    entry->lineStarts.clear();
+    const char* data = entry->text.data();
+    const char* end = data + entry->text.length();
+    const char* lineStart = data;
+    for (int i = 0; i < info.numLines; i++) {
+        entry->lineStarts.push_back(lineStart - data);
+        const char* newline = static_cast<const char*>(memchr(lineStart, '\n', end - lineStart));
+        lineStart = newline == nullptr ? end : newline + 1;
+    }
+
+    return *entry;
+}
\ No newline at end of file
@@ -0,0 +1,91 @@
+#ifndef MAPPEDFILE_H_
+#define MAPPEDFILE_H_
+
+#include <string>
+#include <string_view>
+#include <vector>
+#include <cstddef>
+
+// A read-only view of a file's contents, memory-mapped where the platform allows it, together with an
+// index of where every line starts. Nothing is copied out of the file until a caller asks for a line,
+// so opening a huge file only costs one pass over it to find the newlines.
+// For huge files that are mostly read, the contents can instead be held compressed in memory, in blocks of
+// whole lines, with each thread keeping its own small cache of the blocks it's reading decompressed.
+class MappedFile {
+public:
+    MappedFile();
+    ~MappedFile();
+
+    // Map a file and index its lines, returning false if it can't be opened
+    // If compress is true, its contents are compressed into memory instead, and the mapping is let go
+    bool open(const std::string& file, bool compress = false);
+    // Map a file without indexing its lines, for files that aren't text, returning false if it can't be opened
+    // Its bytes are read through data() instead of line(), and pages of it that are only read are shared
+    // with every other process mapping the same file
+    bool map(const std::string& file);
+
+    // Return the number of lines in the file (a final line without a newline still counts)
+    int lineCount() const;
+    // Return the text of a line, without its newline or a trailing carriage return
+    // If the file is compressed the text is in this thread's cache, so it's only valid until lines from
+    // CACHE_BLOCKS other blocks have been read on the same thread, unless it's pinned
+    std::string_view line(int index) const;
+    // Return the file's contents and their size in bytes (neither is kept for a file opened with compress)
+    const char* data() const;
+    size_t size() const;
+    // Return how much memory the file's contents and index take up, not counting pages that are only mapped
+    size_t memoryUsage() const;
+
+    // How many decompressed blocks each thread keeps
+    static const int CACHE_BLOCKS = 16;
+
+    // While a thread has a Pin, none of the blocks it reads lines from are dropped from its cache, which grows
+    // past CACHE_BLOCKS if it has to; so a caller can read any number of lines and keep every view it got
+    // (the cache shrinks back once the Pin is gone and other blocks are read)
+    class Pin {
+    public:
+        Pin();
+        ~Pin();
+    private:
+        // Pins are only ever made on the stack, for the length of one call
+        Pin(const Pin&);
+        Pin& operator=(const Pin&);
+    };
+private:
+    // A run of whole lines that's compressed together
+    struct Block {
+        int firstLine;
+        int numLines;
+        size_t offset;          // Where its compressed bytes start in m_compressed
+        size_t compressedSize;
+        size_t size;            // How big it is decompressed
+    };
+    // A block decompressed into a thread's cache
+    struct CachedBlock;
+
+    const char* m_data;     // The file's contents
+    size_t m_size;          // Number of bytes in the file
+    bool m_mapped;          // Whether m_data points at a mapping (otherwise it points into m_buffer)
+    std::vector<char> m_buffer;         // Holds the file's contents when it can't be mapped
+    std::vector<size_t> m_lineStarts;   // Byte offset at which each line starts (unless compressed)
+    std::vector<Block> m_blocks;        // The compressed blocks, in order (empty unless compressed)
+    std::string m_compressed;
+    unsigned long long m_id;    // Tells this file's blocks apart from other files' in the caches; never reused
+
+    // A mapping can't be shared between two owners, so it can't be copied
+    MappedFile(const MappedFile&);
+    MappedFile& operator=(const MappedFile&);
+
+    // Unmap/free the current contents
+    void close();
+    // Unmap/free the uncompressed contents, but keep any compressed ones
+    void release();
+    // Find the start of every line with a memchr-driven scan for newlines
+    void indexLines();
+    // Compress the contents into blocks of whole lines
+    void compressBlocks();
+    // Return the given block decompressed, from this thread's cache if it's there
+    const CachedBlock& cachedBlock(int block) const;
+};
+
+#endif // MAPPEDFILE_H_
\ No newline at end of file
@@ -1,29 +1,23 @@
 #include "StudentSpellCheck.h"
 #include <string>
+#include <string_view>
 #include <vector>
 #include <iostream>
 #include <fstream>
 #include <cctype>
+#include <algorithm>
+#include <cstdint>
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
 
 SpellCheck* createSpellCheck() {
     return new StudentSpellCheck;
 }
 
-StudentSpellCheck::StudentSpellCheck() {
-    // Create our root node and have the value representing it be an asterisk
-    m_root = createTrieNode();
+StudentSpellCheck::StudentSpellCheck() : m_compact(false) {}
 
-    // Create a character array with every letter from the dictionary
-    // This includes each letter 'a' through 'z' plus the apostrophe
-    for (char c = 'a'; c <= 'z'; c++) {
-        dictionaryLetters.push_back(c);
-    }
-    dictionaryLetters.push_back('\'');
-}
-
-StudentSpellCheck::~StudentSpellCheck() {
-    destroyRecursively(m_root);
-}
+StudentSpellCheck::~StudentSpellCheck() {}
 
 bool StudentSpellCheck::load(std::string dictionaryFile) {
     std::ifstream infile(dictionaryFile);
@@ -31,130 +25,399 @@ bool StudentSpellCheck::load(std::string dictionaryFile) {
         return false;
     }
 
-    // Insert every word in the dictionary into the trie
+    // The dictionary is built all at once, so the words of any dictionary loaded before this one go into it again
+    std::vector<std::string> words;
+    listWords(words);
+
+    // A compiled dictionary is mapped as it is, in O(1) time, unless there are words from before to add to it
+    // or the dictionary is compact
+    DoubleArrayTrie compiled;
+    if (compiled.open(dictionaryFile)) {
+        if (words.empty() && !m_compact) {
+            return m_trie.open(dictionaryFile);
+        }
+
+        std::vector<std::string> compiledWords;
+        compiled.listWords(compiledWords);
+        words.insert(words.end(), compiledWords.begin(), compiledWords.end());
+        build(words);
+        return true;
+    }
+
+    // Insert every word in the dictionary, leaving out any characters that can't be in a word
+    // (such as the carriage return of a dictionary written on Windows)
     std::string word;
     while (getline(infile, word)) {
-        insertWord(word);
+        word.erase(std::remove_if(word.begin(), word.end(), [](char c) {
+            return DoubleArrayTrie::code(c) == DoubleArrayTrie::NO_CODE;
+        }), word.end());
+        words.push_back(word);
     }
+    build(words);
 
     return true;
 }
 
-bool StudentSpellCheck::spellCheck(std::string word, int maxSuggestions, std::vector<std::string>& suggestions) {
-    // If the word is in the dictionary, then it doesn't need to be spell checked
-    if (contains(word)) {
-        return true;
+bool StudentSpellCheck::save(std::string dictionaryFile) {
+    if (!m_compact) {
+        return m_trie.save(dictionaryFile);
     }
 
-    suggestions.clear();
+    // A compiled dictionary is always a trie, so that it can be mapped
+    std::vector<std::string> words;
+    m_dawg.listWords(words);
+    DoubleArrayTrie trie;
+    trie.build(words);
+    return trie.save(dictionaryFile);
+}
 
-    for (size_t i = 0; i < word.length(); i++) {
-        // Only a max number of suggestions are allowed in the suggestions vector
-        if (suggestions.size() >= maxSuggestions) {
-            break;
-        }
+void StudentSpellCheck::setCompactDictionary(bool compact) {
+    if (compact == m_compact) {
+        return;
+    }
 
-        std::string prefix = word.substr(0, i);
-        std::string suffix = word.substr(i + 1);
+    std::vector<std::string> words;
+    listWords(words);
+    m_compact = compact;
+    build(words);
+}
 
-        // Substitute 1 char in the word at a time with every valid letter in the dictionary
-        // to see if it's a valid spell check suggestion to the word misspelled
-        // This is a constant operation because dictionaryLetters has a constant size
-        for (const char& c : dictionaryLetters) {
-            // Create this possible suggestion
-            std::string suggestion = prefix + c + suffix;
+// How many edits away from a misspelled word its suggestions can be
+const int MAX_EDITS = 2;
+
+namespace {
+
+// A word in the dictionary close enough to a misspelled word to suggest
+struct Candidate {
+    int distance;           // How many edits away from the misspelled word it is
+    int firstDifference;    // Where it first differs from the misspelled word
+    std::vector<int> codes; // The codes of its characters
+};
+
+// What a search for suggestions keeps track of as it walks down the dictionary
+struct SuggestionSearch {
+    int minEdits;               // How close a word has to be to have been found by an earlier search
+    int maxEdits;               // How many edits away from the misspelled word this search goes
+    size_t maxCandidates;       // How many of the best candidates are kept
+    std::vector<int> word;      // The codes of the misspelled word's characters
+    std::vector<int> path;      // The codes from the root to the state being searched
+    // The edit distances of the path so far from the misspelled word, as rows of word.size() + 1 columns:
+    // row d, column j is the distance between the first d characters of the path and the first j of the word
+    std::vector<int> rows;
+    std::vector<Candidate> candidates;  // The best candidates found so far, best first
+};
 
-            if (contains(suggestion) && suggestions.size() < maxSuggestions) {
-                suggestions.push_back(suggestion);
-            }
-        }
-    }
+}
 
-    return false;
+// Return the index of the lowest bit set in bits, which mustn't be 0
+static int lowestBit(uint32_t bits) {
+#ifdef _MSC_VER
+    unsigned long index;
+    _BitScanForward(&index, bits);
+    return index;
+#else
+    return __builtin_ctz(bits);
+#endif
 }
 
-void StudentSpellCheck::spellCheckLine(const std::string& line, std::vector<SpellCheck::Position>& problems) {
-    problems.clear();
+// Return whether the first length characters of the path, distance edits away from the misspelled word and
+// first differing from it at firstDifference, come before candidate: closest first, then by where they first
+// differ from the word, then in order of their codes (so single substitutions come in the same order as always)
+static bool comesBefore(const SuggestionSearch& search, int length, int distance, int firstDifference,
+                        const Candidate& candidate) {
+    if (distance != candidate.distance) {
+        return distance < candidate.distance;
+    }
+    if (firstDifference != candidate.firstDifference) {
+        return firstDifference < candidate.firstDifference;
+    }
+    return std::lexicographical_compare(search.path.begin(), search.path.begin() + length,
+                                        candidate.codes.begin(), candidate.codes.end());
+}
 
-    // Get the positions of words in the line
-    std::vector<SpellCheck::Position> positions = getPositions(line);
+// Add the first length characters of the path, distance edits away from the misspelled word, to the candidates
+// if they're among the best maxCandidates found so far
+// Time Complexity: O(K + L) for K candidates kept and a word of length L, with nothing allocated once the
+// candidates' vectors have grown
+static void addCandidate(SuggestionSearch& search, int length, int distance) {
+    int firstDifference = 0;
+    while (firstDifference < std::min(length, (int) search.word.size())
+           && search.path[firstDifference] == search.word[firstDifference]) {
+        firstDifference++;
+    }
 
-    // Loop through each position
-    for (std::vector<SpellCheck::Position>::iterator it = positions.begin(); it != positions.end(); it++) {
-        Position pos = *it;
-        // Create the word formed by the start and end indices of a position
-        std::string word = line.substr(pos.start, pos.end - pos.start + 1);
+    std::vector<Candidate>& candidates = search.candidates;
+    size_t position = candidates.size();
+    while (position > 0 && comesBefore(search, length, distance, firstDifference, candidates[position - 1])) {
+        position--;
+    }
+    if (position >= search.maxCandidates) {
+        return;
+    }
 
-        // If it's not a valid word, add it to problems
-        if (!contains(word)) {
-            problems.push_back(pos);
+    // The worst candidate drops off the end once there are enough, and its place is reused for this one
+    if (candidates.size() < search.maxCandidates) {
+        candidates.emplace_back();
+    }
+    std::rotate(candidates.begin() + position, candidates.end() - 1, candidates.end());
+    Candidate& candidate = candidates[position];
+    candidate.distance = distance;
+    candidate.firstDifference = firstDifference;
+    candidate.codes.assign(search.path.begin(), search.path.begin() + length);
+}
+
+// Add the word that the first depth characters of the path, which lead to state, make with the misspelled word's
+// characters from column on, if it's in dictionary; with every edit used up, that's all that can be
+template <class Dictionary>
+static void followWord(const Dictionary& dictionary, int state, int depth, int column, SuggestionSearch& search) {
+    for (int j = column; j < (int) search.word.size(); j++) {
+        if (search.word[j] == DoubleArrayTrie::NO_CODE) {
+            return;
+        }
+        state = dictionary.child(state, search.word[j]);
+        if (state < 0) {
+            return;
         }
+        search.path[depth++] = search.word[j];
+    }
+
+    if (dictionary.endsWord(state)) {
+        addCandidate(search, depth, search.maxEdits);
     }
 }
 
-void StudentSpellCheck::destroyRecursively(StudentSpellCheck::TrieNode* node) {
-    if (node != nullptr) {
-        // Destroy child nodes
-        for (TrieNode* child : node->children) {
-            destroyRecursively(child);
+// Add every word at or below state, which the first depth characters of the path lead to, to the candidates once
+// every edit is used up (the row of the path has nothing less than maxEdits, and depth is at least 1)
+// The path can then only go on with the rest of the word from a column where the distance is maxEdits, or with
+// the first half of a swap that the path's last character started where the distance was less; most of the
+// states searched are like that, and those words are simply looked up
+template <class Dictionary>
+static void followRow(const Dictionary& dictionary, int state, int depth, SuggestionSearch& search) {
+    int length = search.word.size();
+    int width = length + 1;
+    const int* row = &search.rows[depth * width];
+    const int* previousRow = row - width;
+    const int* word = search.word.data();
+    int maxEdits = search.maxEdits;
+    int last = std::min(length, depth + maxEdits);
+    for (int j = std::max(0, depth - maxEdits); j <= last; j++) {
+        if (row[j] == maxEdits) {
+            followWord(dictionary, state, depth, j, search);
+        }
+        if (j >= 1 && j < length && previousRow[j - 1] < maxEdits
+            && word[j] == search.path[depth - 1] && word[j - 1] != DoubleArrayTrie::NO_CODE) {
+            int next = dictionary.child(state, word[j - 1]);
+            if (next >= 0) {
+                search.path[depth] = word[j - 1];
+                followWord(dictionary, next, depth + 1, j + 1, search);
+            }
         }
-        // Then destroy node
-        delete node;
     }
 }
 
-StudentSpellCheck::TrieNode* StudentSpellCheck::createTrieNode() {
-    TrieNode* node = new TrieNode;
-    node->endsHere = false;
+// Add every word at or below state, which the first depth characters of the path lead to, from the search's
+// minEdits to maxEdits edits away from the misspelled word to the candidates (the row of the path has something
+// less than maxEdits); onWord is whether the path so far is the start of the misspelled word
+// The search reaches words in the order candidates come in apart from their distance, and every word it finds
+// is at least as far away as the ones before it, so once there are enough candidates, no word it could reach
+// later would be better than the worst of them and it stops
+// A row of edit distances is the state of the misspelled word's Levenshtein automaton, so filling in one row per
+// character runs the automaton along the dictionary, and a row with nothing within maxEdits ends the search
+// there (no longer path can do better): the search only ever visits the part of the dictionary that's close
+// to the word
+// Only the columns within maxEdits of the diagonal can be within maxEdits, so only they are filled in, and the
+// rest keep the maxEdits + 1 they started with
+template <class Dictionary>
+static void findCandidates(const Dictionary& dictionary, int state, int depth, bool onWord, SuggestionSearch& search) {
+    int length = search.word.size();
+    int width = length + 1;
+    const int* row = &search.rows[depth * width];
+    const int* previousRow = depth >= 1 ? row - width : nullptr;
+    const int* word = search.word.data();
+    int maxEdits = search.maxEdits;
+    if (row[length] >= search.minEdits && row[length] <= maxEdits && dictionary.endsWord(state)) {
+        addCandidate(search, depth, row[length]);
+    }
 
-    // Reserve 27 spaces in a node's children vector to account for each character
-    // 'a' through 'z' (numbered 0-25) plus the apostrophe character (numbered 26)
+    int* nextRow = &search.rows[(depth + 1) * width];
+    int nextFirst = std::max(1, depth + 1 - maxEdits);
+    int nextLast = std::min(length, depth + 1 + maxEdits);
 
-    const int NUM_CHARACTERS = 27;
-    for (int i = 0; i < NUM_CHARACTERS; i++) {
-        node->children.push_back(nullptr);
+    // Words that differ from the misspelled word sooner come first, so a child that goes on with the word
+    // is searched after the others; the rest go in order of their codes, which keeps the words in order
+    uint32_t codes = dictionary.childCodes(state);
+    uint32_t wordCode = 0;
+    if (onWord && depth < length && word[depth] != DoubleArrayTrie::NO_CODE) {
+        wordCode = codes & (1u << word[depth]);
+    }
+    const uint32_t batches[] = { codes & ~wordCode, wordCode };
+
+    // Most children only go on with the word's characters from the columns of their row, and each child's
+    // lookups are in a different part of the dictionary, so they're all asked for at once to wait on memory
+    // together rather than one after another
+    uint32_t followed = 0;
+    for (int j = std::max(0, depth + 1 - maxEdits); j <= nextLast; j++) {
+        if (j == length) {
+            followed |= 1u << DoubleArrayTrie::END;
+        } else if (word[j] != DoubleArrayTrie::NO_CODE) {
+            followed |= 1u << word[j];
+        }
     }
+    int children[DoubleArrayTrie::NUM_CODES];
+    for (uint32_t remaining = codes; remaining != 0; remaining &= remaining - 1) {
+        int code = lowestBit(remaining);
+        children[code] = dictionary.child(state, code);
+        dictionary.prefetch(children[code], followed);
+    }
+    for (uint32_t batch : batches) {
+        for (; batch != 0; batch &= batch - 1) {
+            if (search.candidates.size() >= search.maxCandidates) {
+                return;
+            }
+            int code = lowestBit(batch);
+
+            // Fill in the next row: the path's new character is inserted, deleted, kept or substituted,
+            // or swapped with the one before it
+            search.path[depth] = code;
+            nextRow[0] = depth + 1;
+            int nextSmallest = nextRow[0];
+            for (int j = nextFirst; j <= nextLast; j++) {
+                int distance = std::min(row[j] + 1, nextRow[j - 1] + 1);
+                distance = std::min(distance, row[j - 1] + (word[j - 1] == code ? 0 : 1));
+                if (depth >= 1 && j >= 2 && word[j - 2] == code && word[j - 1] == search.path[depth - 1]) {
+                    distance = std::min(distance, previousRow[j - 2] + 1);
+                }
+                nextRow[j] = distance;
+                nextSmallest = std::min(nextSmallest, distance);
+            }
 
-    return node;
+            // With nothing in the row within maxEdits, no word at or below the child can be either
+            if (nextSmallest < maxEdits) {
+                findCandidates(dictionary, children[code], depth + 1, wordCode == 1u << code, search);
+            } else if (nextSmallest == maxEdits) {
+                followRow(dictionary, children[code], depth + 1, search);
+            }
+        }
+    }
 }
 
-void StudentSpellCheck::insertWord(std::string word) {
-    TrieNode* temp = m_root;
+// Fill suggestions with the words in dictionary within MAX_EDITS insertions, deletions, substitutions and swaps
+// of adjacent characters of word, closest first, then by where they first differ from it, then in order of their
+// codes (so single substitutions come in the same order as always), until there are maxSuggestions of them
+// Suggestions keep the case of the characters they share with word at its start and end
+// Time Complexity: proportional to the part of the dictionary within MAX_EDITS of word's prefixes, which doesn't
+// grow with the size of the dictionary so much as with how crowded it is around word
+template <class Dictionary>
+static void findSuggestions(const Dictionary& dictionary, const std::string& word, size_t maxSuggestions,
+                            std::vector<std::string>& suggestions) {
+    if (maxSuggestions == 0) {
+        return;
+    }
 
-    for (unsigned int k = 0; k < word.length(); k++) {
-        char c = tolower(word.at(k));
-        int index = c == '\'' ? 26 : c - 'a';   // get the index 0-26 corresponding to a letter
+    // No path more than MAX_EDITS characters longer than the word can be close enough to it
+    SuggestionSearch search;
+    search.maxCandidates = maxSuggestions;
+    int length = word.length();
+    int width = length + 1;
+    for (char ch : word) {
+        search.word.push_back(DoubleArrayTrie::code(ch));
+    }
+    search.path.resize(length + MAX_EDITS + 1);
+
+    // The part of the dictionary within one edit of a word is a small fraction of the part within two, and
+    // closer words come first, so the search only goes further out if there aren't enough words close by,
+    // keeping the words it found and looking for the ones further away to follow them
+    search.minEdits = 0;
+    for (search.maxEdits = 1; search.maxEdits <= MAX_EDITS; search.maxEdits++) {
+        search.rows.assign((length + search.maxEdits + 2) * width, search.maxEdits + 1);
+        for (int j = 0; j <= std::min(length, search.maxEdits); j++) {
+            search.rows[j] = j;
+        }
+        findCandidates(dictionary, Dictionary::ROOT, 0, true, search);
 
-        // If there is no node at that index, create one
-        if (temp->children.at(index) == nullptr) {
-            temp->children.at(index) = createTrieNode();
+        if (search.candidates.size() >= maxSuggestions) {
+            break;
+        }
+        search.minEdits = search.maxEdits + 1;
+    }
+
+    for (const Candidate& candidate : search.candidates) {
+        const std::vector<int>& codes = candidate.codes;
+        int found = codes.size();
+
+        // The characters the suggestion shares with the word at its start and end are the word's own
+        int prefix = candidate.firstDifference;
+        int suffix = 0;
+        while (suffix < found - prefix && suffix < length - prefix
+               && search.word[length - 1 - suffix] == codes[found - 1 - suffix]) {
+            suffix++;
         }
 
-        temp = temp->children.at(index);
+        suggestions.emplace_back(word, 0, prefix);
+        for (int i = prefix; i < found - suffix; i++) {
+            suggestions.back() += DoubleArrayTrie::character(codes[i]);
+        }
+        suggestions.back().append(word, length - suffix, suffix);
     }
+}
 
-    // Indicate that the last character added in a word indicates the end of the word
-    temp->endsHere = true;
+bool StudentSpellCheck::spellCheck(std::string word, int maxSuggestions, std::vector<std::string>& suggestions) {
+    // If the word is in the dictionary, then it doesn't need to be spell checked
+    if (contains(word)) {
+        return true;
+    }
+
+    suggestions.clear();
+    if (m_compact) {
+        findSuggestions(m_dawg, word, maxSuggestions, suggestions);
+    } else {
+        findSuggestions(m_trie, word, maxSuggestions, suggestions);
+    }
+
+    return false;
 }
 
-// Returns whether a word is in our trie dictionary
-// Time Complexity: O(L) where L is the length of the word
-bool StudentSpellCheck::contains(std::string word) {
-    TrieNode* temp = m_root;
+void StudentSpellCheck::spellCheckLine(const std::string& line, std::vector<SpellCheck::Position>& problems) {
+    problems.clear();
+
+    // Get the positions of words in the line
+    std::vector<SpellCheck::Position> positions = getPositions(line);
 
-    for (unsigned int k = 0; k < word.length(); k++) {
-        char c = tolower(word.at(k));
-        int index = c == '\'' ? 26 : c - 'a';   // get the index 0-26 corresponding to a letter
+    // Loop through each position
+    for (std::vector<SpellCheck::Position>::iterator it = positions.begin(); it != positions.end(); it++) {
+        Position pos = *it;
+        // Create the word formed by the start and end indices of a position
+        std::string word = line.substr(pos.start, pos.end - pos.start + 1);
 
-        // If there is no node at that index, the word isn't in the dictionary
-        if (temp->children.at(index) == nullptr) {
-            return false;
+        // If it's not a valid word, add it to problems
+        if (!contains(word)) {
+            problems.push_back(pos);
         }
+    }
+}
+
+bool StudentSpellCheck::contains(std::string_view word) const {
+    return m_compact ? m_dawg.contains(word) : m_trie.contains(word);
+}
 
-        temp = temp->children.at(index);
+void StudentSpellCheck::listWords(std::vector<std::string>& words) const {
+    if (m_compact) {
+        m_dawg.listWords(words);
+    } else {
+        m_trie.listWords(words);
     }
+}
 
-    return temp->endsHere;
+void StudentSpellCheck::build(std::vector<std::string>& words) {
+    // Only one of the two holds the words, and the other is emptied so it doesn't take up memory
+    std::vector<std::string> none;
+    if (m_compact) {
+        m_dawg.build(words);
+        m_trie.build(none);
+    } else {
+        m_trie.build(words);
+        m_dawg.build(none);
+    }
 }
 
 std::vector<SpellCheck::Position> StudentSpellCheck::getPositions(std::string line) {
@@ -2,8 +2,11 @@
 #define STUDENTSPELLCHECK_H_
 
 #include "SpellCheck.h"
+#include "DoubleArrayTrie.h"
+#include "Dawg.h"
 
 #include <string>
+#include <string_view>
 #include <vector>
 
 class StudentSpellCheck : public SpellCheck {
@@ -11,24 +14,26 @@ public:
     StudentSpellCheck();
     virtual ~StudentSpellCheck();
     bool load(std::string dict_file);
+    // Write the dictionary in a compiled form that load maps straight into memory instead of parsing,
+    // returning false if it can't be written
+    bool save(std::string dict_file);
+    // Choose whether the dictionary is kept as a minimized word graph, which shares the endings of words as well
+    // as their beginnings and takes a fraction of the memory, rather than as a trie that a compiled dictionary
+    // can be mapped into; the words already loaded are moved over
+    void setCompactDictionary(bool compact);
     bool spellCheck(std::string word, int maxSuggestions, std::vector<std::string>& suggestions);
     void spellCheckLine(const std::string& line, std::vector<Position>& problems);
 private:
-    struct TrieNode {
-        bool endsHere;  // Denotes whether this TrieNode is the end of a word
-        std::vector<TrieNode*> children;    // The children of any given TrieNode
-    };
-    TrieNode* m_root;
-    std::vector<char> dictionaryLetters;
+    DoubleArrayTrie m_trie;     // Every word in the dictionary, unless it's compact
+    Dawg m_dawg;        // Every word in the dictionary, if it's compact
+    bool m_compact;
 
-    // Destroy each node in a trie recursively
-    void destroyRecursively(TrieNode* node);
-    // Create a node to be contained in a trie
-    TrieNode* createTrieNode();
-    // Insert a word into the trie
-    void insertWord(std::string word);
-    // Check whether a word is in a tree
-    bool contains(std::string word);
+    // Return whether word is in the dictionary, ignoring case
+    bool contains(std::string_view word) const;
+    // Fill words with every word in the dictionary
+    void listWords(std::vector<std::string>& words) const;
+    // Replace the contents of the dictionary with words
+    void build(std::vector<std::string>& words);
     // Get the positions of words in a line
     std::vector<SpellCheck::Position> getPositions(std::string line);
 };
@@ -1,72 +1,210 @@
 #include "StudentTextEditor.h"
 #include "Undo.h"
+#include "StudentUndo.h"
 #include <string>
 #include <vector>
 #include <iostream>
-#include <fstream>
+#include <memory>
+#include <chrono>
+#include <algorithm>
+#include <cstring>
 
 TextEditor* createTextEditor(Undo* un) {
     return new StudentTextEditor(un);
 }
 
+// One change to the document made while undoing several operations at once, which may be made of several
+// operations' changes merged together
+struct StudentTextEditor::MergedChange {
+    bool insert;        // Whether text is inserted at row, col (otherwise count characters starting there are erased)
+    int row;
+    int col;
+    int count;
+    int endRow;         // For an insertion, where the inserted text ends
+    int endCol;
+    std::string front;  // Text inserted in front of text, stored backwards so that adding to the front is cheap
+    std::string text;
+};
+
+// Find where text ends if it starts at row, col
+static void findEnd(int row, int col, std::string_view text, int& endRow, int& endCol) {
+    endRow = row;
+    endCol = col;
+    size_t lineStart = 0;
+    for (size_t newline = text.find('\n'); newline != std::string_view::npos; newline = text.find('\n', lineStart)) {
+        endRow++;
+        endCol = 0;
+        lineStart = newline + 1;
+    }
+    endCol += text.length() - lineStart;
+}
+
 // Initialize row and col to the first row and first col of the editor
-StudentTextEditor::StudentTextEditor(Undo* undo) : TextEditor(undo), m_row(0), m_col(0) {
-    // Push an empty line to the editor so that the currentLine iterator has something to point to
-    m_lines.push_back("");
-    m_currentLine = m_lines.begin();
+StudentTextEditor::StudentTextEditor(Undo* undo) : TextEditor(undo), m_row(0), m_col(0), m_activeRow(-1), m_lastSave(),
+    m_compressLines(false) {
+    // Push an empty line to the editor so that the currentLine pointer has something to point to
+    m_lines.pushBack("");
+    m_currentLine = &m_lines.at(0);
+    m_diff.reset(m_lines);
 }
 
-// Clear the list of lines in O(N) time
+// Clear the rope of lines in O(N) time
 StudentTextEditor::~StudentTextEditor() {
     m_lines.clear();
+
+    // Closing the editor throws away unsaved edits on purpose, so they shouldn't be recovered later
+    m_journal.discard();
 }
 
 bool StudentTextEditor::load(std::string file) {
-    std::ifstream infile(file);
-    if (!infile) {
+    // Map the file and find where its lines start; the lines themselves are only
+    // copied into the rope once the user moves onto them or edits them
+    std::shared_ptr<MappedFile> source = std::make_shared<MappedFile>();
+    if (!source->open(file, m_compressLines)) {
         return false;
     }
 
     // Reset the row, col, lines, and undo stack because we're loading a different file
     reset();
+    m_lines.assign(source);
 
-    std::string line;
-    while (getline(infile, line)) {
-        // Remove the carriage character from the line if it is there
-        if (line.length() > 0 && line.at(line.length() - 1) == '\r') {
-            line = line.substr(0, line.length() - 1);
-        }
-        m_lines.push_back(line);
+    // An empty file still has one (empty) line to edit
+    if (m_lines.size() == 0) {
+        m_lines.pushBack("");
     }
 
-    // Have the current line iterator point to the first line in the file
-    m_currentLine = m_lines.begin();
+    // Have the current line pointer point to the first line in the file
+    m_currentLine = &m_lines.at(0);
+    m_diff.reset(m_lines);
+
+    // If the editor died last time with edits to this file that weren't saved, redo them, then
+    // keep recording new edits after them
+    std::vector<EditJournal::Entry> entries;
+    int numReplayed = 0;
+    if (m_journal.recover(file, entries)) {
+        numReplayed = replayJournal(entries);
+    }
+    m_journal.open(file, numReplayed);
 
     return true;
 }
 
 bool StudentTextEditor::save(std::string file) {
-    std::ofstream outfile(file);
-    if (!outfile) {
+    flushActiveLine();
+
+    // This save makes any autosave that hasn't been written yet pointless, and one being written
+    // right now might be to the same file
+    m_autoSaver.cancel();
+
+    std::chrono::steady_clock::time_point startTime = std::chrono::steady_clock::now();
+    long long bytesWritten;
+    if (!AutoSaver::writeFile(m_lines, file, bytesWritten)) {
         return false;
     }
 
-    // Write each line to the file specified
-    for (std::list<std::string>::iterator it = m_lines.begin(); it != m_lines.end(); it++) {
-        outfile << *it << std::endl;
-    }
+    // Record how long the save took so callers can report the throughput
+    m_lastSave.bytes = bytesWritten;
+    m_lastSave.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count();
+    m_lastSave.bytesPerSecond = m_lastSave.seconds > 0 ? bytesWritten / m_lastSave.seconds : 0;
+
+    // The saved file has every edit so far, so the journal and the diff start over from it
+    m_journal.discard();
+    m_journal.open(file);
+    m_diff.reset(m_lines);
 
     return true;
 }
 
-// Reset row and col to 0, clear the lines list, and clear the undo stack
+LineRope StudentTextEditor::snapshot() {
+    // The line being typed into isn't in the rope, so it has to be put back before the rope is shared
+    flushActiveLine();
+    return m_lines;
+}
+
+void StudentTextEditor::setCompressedStorage(bool compress) {
+    m_compressLines = compress;
+}
+
+const StudentTextEditor::SaveStats& StudentTextEditor::lastSaveStats() const {
+    return m_lastSave;
+}
+
+void StudentTextEditor::autosave(std::string file) {
+    // The snapshot is all the editor has to wait for; the worker does the writing
+    std::chrono::steady_clock::time_point startTime = std::chrono::steady_clock::now();
+    LineRope lines = snapshot();
+    double snapshotSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count();
+
+    m_autoSaver.request(lines, file, snapshotSeconds);
+}
+
+AutoSaver::Stats StudentTextEditor::autosaveStats() const {
+    return m_autoSaver.stats();
+}
+
+void StudentTextEditor::activateCurrentLine() {
+    if (m_activeRow == m_row) {
+        return;
+    }
+
+    // Only one line can be in the gap buffer at a time
+    flushActiveLine();
+    m_activeLine.assign(*m_currentLine);
+    m_activeRow = m_row;
+
+    // Everything that reads lines for the screen reads this one from the gap buffer from now on
+    m_diff.setActiveLine(m_activeRow, &m_activeLine);
+    m_layout.setActiveLine(m_activeRow, &m_activeLine);
+}
+
+void StudentTextEditor::flushActiveLine() {
+    if (m_activeRow < 0) {
+        return;
+    }
+
+    // The active line is always the current line, since moving off of it flushes it
+    // Its node might be shared with a snapshot though, so write through a freshly owned copy
+    LineView text = m_activeLine.view();
+    m_currentLine = &m_lines.at(m_activeRow);
+    m_currentLine->assign(text.first.data(), text.first.length());
+    m_currentLine->append(text.second.data(), text.second.length());
+    m_activeRow = -1;
+    m_diff.setActiveLine(-1, nullptr);
+    m_layout.setActiveLine(-1, nullptr);
+}
+
+int StudentTextEditor::currentLineLength() const {
+    return m_activeRow == m_row ? m_activeLine.length() : m_currentLine->length();
+}
+
+void StudentTextEditor::markChanged(int row, int count, int newCount) {
+    m_diff.markChanged(row, count, newCount);
+    m_layout.markChanged(row, count, newCount);
+}
+
+void StudentTextEditor::markEdited(int row, int col, int erased, int inserted) {
+    m_diff.markChanged(row, 1, 1);
+    m_layout.markEdited(row, col, erased, inserted);
+}
+
+// Reset row and col to 0, clear the lines down to a single empty line, and clear the undo stack
 void StudentTextEditor::reset() {
     m_row = 0;
     m_col = 0;
 
     m_lines.clear();
+    m_lines.pushBack("");
+    m_currentLine = &m_lines.at(0);
+    m_activeRow = -1;   // The line being typed into was just thrown away
+    m_diff.setActiveLine(-1, nullptr);
+    m_layout.setActiveLine(-1, nullptr);
 
     getUndo()->clear();
+    m_journal.discard();
+    m_search.invalidate();
+    m_cursors.clear();
+    m_diff.reset(m_lines);
+    m_layout.clear();
 }
 
 void StudentTextEditor::move(Dir dir) {
@@ -74,8 +212,9 @@ void StudentTextEditor::move(Dir dir) {
     case UP:
         // If the current row isn't the first row move it up 1
         if (m_row > 0) {
+            flushActiveLine();
             m_row--;
-            m_currentLine--;
+            m_currentLine = &m_lines.at(m_row);
 
             // Have col be the last character in the line the user moved to if col is greater than the line's length
             if (m_col > m_currentLine->length()) {
@@ -86,8 +225,9 @@ void StudentTextEditor::move(Dir dir) {
     case DOWN:
         // If the current row isn't the last row move it down 1
         if (m_row < m_lines.size() - 1) {
+            flushActiveLine();
             m_row++;
-            m_currentLine++;
+            m_currentLine = &m_lines.at(m_row);
 
             // Have col be the last character in the line the user moved to if col is greater than the line's length
             if (m_col > m_currentLine->length()) {
@@ -100,8 +240,9 @@ void StudentTextEditor::move(Dir dir) {
         // the cursor at the end of the previous line
         if (m_col == 0) {
             if (m_row > 0) {
+                flushActiveLine();
                 m_row--;
-                m_currentLine--;
+                m_currentLine = &m_lines.at(m_row);
                 m_col = m_currentLine->length();
             }
         } else if (m_col > 0) {
@@ -111,13 +252,14 @@ void StudentTextEditor::move(Dir dir) {
     case RIGHT:
         // If the user goes right at the last col of a row that's not the last row then place
         // the cursor at the beginning of the next line
-        if (m_col == m_currentLine->length()) {
+        if (m_col == currentLineLength()) {
             if (m_row < m_lines.size() - 1) {
+                flushActiveLine();
                 m_row++;
-                m_currentLine++;
+                m_currentLine = &m_lines.at(m_row);
                 m_col = 0;
             }
-        } else if (m_col < m_currentLine->length()) {
+        } else if (m_col < currentLineLength()) {
             m_col++;
         }
         break;
@@ -125,36 +267,37 @@ void StudentTextEditor::move(Dir dir) {
         m_col = 0;
         break;
     case END:
-        m_col = m_currentLine->length();
+        m_col = currentLineLength();
         break;
     }
 }
 
 void StudentTextEditor::del() {
-    std::string& line = *m_currentLine;
+    m_journal.append(EditJournal::DELETE, m_row, m_col);
+    m_search.invalidate();
 
     // If the user presses del at the last col of a row that's not the last row
     // then that line must be joined by the next line
-    if (m_col == line.length()) {
+    if (m_col == currentLineLength()) {
         if (m_row != m_lines.size() - 1) {
-            std::list<std::string>::iterator nextLine = m_currentLine;
-            nextLine++;
-
-            // Concatenate the current line with the next line
-            std::string newLine = line + *nextLine;
+            flushActiveLine();
+            std::string& line = m_lines.at(m_row);
 
-            // Erase both the next and current line in the list then insert the newly created line at its correct position
-            m_lines.erase(nextLine);
-            m_currentLine = m_lines.erase(m_currentLine);
-            m_currentLine = m_lines.insert(m_currentLine, newLine);
+            // Append the next line to the current line, then erase the next line from the rope
+            line += m_lines.view(m_row + 1);
+            m_lines.erase(m_row + 1);
+            m_currentLine = &m_lines.at(m_row);
+            markChanged(m_row, 2, 1);
 
             // Tell undo that the user has joined two lines
             getUndo()->submit(Undo::Action::JOIN, m_row, m_col);
         }
     } else {
         // Trivially delete the character at the cursor
-        char ch = line.at(m_col);
-        line.erase(m_col, 1);
+        activateCurrentLine();
+        char ch = m_activeLine.at(m_col);
+        m_activeLine.erase(m_col, 1);
+        markEdited(m_row, m_col, 1, 0);
 
         // Tell undo that the user has deleted a character
         getUndo()->submit(Undo::Action::DELETE, m_row, m_col, ch);
@@ -162,14 +305,17 @@ void StudentTextEditor::del() {
 }
 
 void StudentTextEditor::backspace() {
-    std::string& line = *m_currentLine;
+    m_journal.append(EditJournal::BACKSPACE, m_row, m_col);
+    m_search.invalidate();
 
     if (m_col > 0) {
         // Trivially delete the previous character from its line
+        activateCurrentLine();
         m_col--;
-        char ch = line.at(m_col);
+        char ch = m_activeLine.at(m_col);
 
-        line.erase(m_col, 1);
+        m_activeLine.erase(m_col, 1);
+        markEdited(m_row, m_col, 1, 0);
 
         // Tell undo that the user has deleted a character
         getUndo()->submit(Undo::Action::DELETE, m_row, m_col, ch);
@@ -177,22 +323,18 @@ void StudentTextEditor::backspace() {
         if (m_row > 0) {
             // If the user presses backspace at the first col of a row that's not the first row
             // then that line must join the previous line
+            flushActiveLine();
+            std::string& prevLine = m_lines.at(m_row - 1);
+            int oldLen = prevLine.length();
 
-            std::list<std::string>::iterator prevLine = m_currentLine;
-            prevLine--;
-
-            int oldLen = prevLine->length();
-
-            // Concatenate the previous line with the current line
-            std::string newLine = *prevLine + line;
-
-            // Erase both the current and previous line then insert the newly created line at its correct position
-            m_lines.erase(m_currentLine);
-            prevLine = m_lines.erase(prevLine);
-            m_currentLine = m_lines.insert(prevLine, newLine);
+            // Append the current line to the previous line, then erase the current line from the rope
+            prevLine += m_lines.view(m_row);
+            m_lines.erase(m_row);
+            markChanged(m_row - 1, 2, 1);
 
             m_row--;
             m_col = oldLen;
+            m_currentLine = &m_lines.at(m_row);
 
             // Tell undo that the user has joined two lines
             getUndo()->submit(Undo::Action::JOIN, m_row, m_col);
@@ -201,25 +343,30 @@ void StudentTextEditor::backspace() {
 }
 
 void StudentTextEditor::insert(char ch) {
-    std::string& line = *m_currentLine;
+    m_journal.append(EditJournal::INSERT, m_row, m_col, ch);
+    m_search.invalidate();
+    activateCurrentLine();
 
-    std::string toInsert;
+    // insert the character(s) at the current col
+    int col = m_col;
     if (ch == '\t') {
-        toInsert = std::string(4, ' '); // a tab = 4 spaces as per the spec
+        m_activeLine.insert(m_col, "    ");    // a tab = 4 spaces as per the spec
+        m_col += 4;
     } else {
-        toInsert = ch;
+        m_activeLine.insert(m_col, ch);
+        m_col++;
     }
-
-    // insert the character(s) at the current col
-    line.insert(m_col, toInsert);
-    m_col += toInsert.length();
+    markEdited(m_row, col, 0, m_col - col);
 
     // Tell undo that the user has inserted the character(s)
     getUndo()->submit(Undo::Action::INSERT, m_row, m_col, ch);
 }
 
 void StudentTextEditor::enter() {
-    std::string& line = *m_currentLine;
+    m_journal.append(EditJournal::ENTER, m_row, m_col);
+    m_search.invalidate();
+    flushActiveLine();
+    std::string& line = m_lines.at(m_row);
 
     // Get the string that are after the col at which the user pressed enter
     std::string postEnter = line.substr(m_col);
@@ -228,8 +375,9 @@ void StudentTextEditor::enter() {
     line.erase(m_col);
 
     // Insert the rest of line at its correct position
-    m_currentLine++;
-    m_currentLine = m_lines.insert(m_currentLine, postEnter);
+    m_lines.insert(m_row + 1, postEnter);
+    m_currentLine = &m_lines.at(m_row + 1);
+    markChanged(m_row, 1, 2);
 
     // Tell undo that the user has split two lines
     getUndo()->submit(Undo::Action::SPLIT, m_row, m_col);
@@ -238,6 +386,338 @@ void StudentTextEditor::enter() {
     m_col = 0;
 }
 
+void StudentTextEditor::insertText(std::string_view text) {
+    // Pasted text follows the same rules as typed text: tabs become 4 spaces and lines end in just '\n'
+    std::string normalized;
+    if (text.find_first_of("\t\r") != std::string_view::npos) {
+        normalized.reserve(text.length());
+        for (char ch : text) {
+            if (ch == '\t') {
+                normalized += "    ";
+            } else if (ch != '\r') {
+                normalized += ch;
+            }
+        }
+        text = normalized;
+    }
+
+    if (text.empty()) {
+        return;
+    }
+    m_journal.appendText(m_row, m_col, text);
+    m_search.invalidate();
+
+    int startRow = m_row;
+    int startCol = m_col;
+
+    if (text.find('\n') == std::string_view::npos) {
+        // Text that stays on one line can go straight into the gap buffer
+        activateCurrentLine();
+        m_activeLine.insert(m_col, text);
+        m_col += text.length();
+        markEdited(m_row, startCol, 0, text.length());
+    } else {
+        flushActiveLine();
+        insertTextAt(m_row, m_col, text, m_row, m_col);
+        m_currentLine = &m_lines.at(m_row);
+    }
+
+    // Tell undo about the whole block at once if it knows how to handle that
+    StudentUndo* undo = dynamic_cast<StudentUndo*>(getUndo());
+    if (undo != nullptr) {
+        undo->submitText(startRow, startCol, text);
+        return;
+    }
+
+    // Otherwise describe it one keystroke at a time
+    int row = startRow;
+    int col = startCol;
+    for (char ch : text) {
+        if (ch == '\n') {
+            getUndo()->submit(Undo::Action::SPLIT, row, col);
+            row++;
+            col = 0;
+        } else {
+            col++;
+            getUndo()->submit(Undo::Action::INSERT, row, col, ch);
+        }
+    }
+}
+
+const std::vector<TextSearch::Match>& StudentTextEditor::search(std::string_view query) {
+    // The line being typed into has to be in the rope to be searched
+    flushActiveLine();
+    return m_search.search(m_lines, query);
+}
+
+int StudentTextEditor::replaceAll(std::string_view query, std::string_view replacement) {
+    // Matches and replacements both have to stay within their lines
+    if (query.empty() || replacement.find('\n') != std::string_view::npos) {
+        return -1;
+    }
+
+    const std::vector<TextSearch::Match>& matches = search(query);
+    if (matches.empty()) {
+        return 0;
+    }
+    m_journal.appendReplace(m_row, m_col, query, replacement);
+
+    // Every replacement is recorded in one group, so a single undo reverses all of them
+    StudentUndo* undo = dynamic_cast<StudentUndo*>(getUndo());
+    if (undo != nullptr) {
+        undo->beginGroup();
+    }
+
+    int numReplaced = 0;
+    size_t i = 0;
+    while (i < matches.size()) {
+        // Build the new version of each touched line in one pass and store it once
+        int row = matches[i].row;
+        std::string_view line = m_lines.view(row);
+        std::string newLine;
+        newLine.reserve(line.length());
+        size_t copied = 0;      // How much of the old line has been copied (or replaced) so far
+
+        for (; i < matches.size() && matches[i].row == row; i++) {
+            // Matches can overlap, so skip any that start inside the text that was just replaced
+            size_t col = matches[i].col;
+            if (col < copied) {
+                continue;
+            }
+
+            newLine.append(line.substr(copied, col - copied));
+            int newCol = newLine.length();
+            newLine.append(replacement);
+            copied = col + query.length();
+            numReplaced++;
+
+            // Undo sees each replacement as deleting the query and inserting the replacement where it was
+            if (undo != nullptr) {
+                undo->submitDeletedText(row, newCol, query);
+                if (!replacement.empty()) {
+                    undo->submitText(row, newCol, replacement);
+                }
+            } else {
+                for (char ch : query) {
+                    getUndo()->submit(Undo::Action::DELETE, row, newCol, ch);
+                }
+                for (size_t k = 0; k < replacement.length(); k++) {
+                    getUndo()->submit(Undo::Action::INSERT, row, newCol + k + 1, replacement[k]);
+                }
+            }
+        }
+
+        newLine.append(line.substr(copied));
+        m_lines.at(row) = std::move(newLine);
+        markChanged(row, 1, 1);
+    }
+
+    if (undo != nullptr) {
+        undo->endGroup();
+    }
+    m_search.invalidate();
+
+    // The cursor stays on its row, but that row may have gotten shorter
+    m_currentLine = &m_lines.at(m_row);
+    if (m_col > (int) m_currentLine->length()) {
+        m_col = m_currentLine->length();
+    }
+
+    return numReplaced;
+}
+
+// Order cursors by row, then by col
+static bool cursorBefore(const StudentTextEditor::Cursor& a, const StudentTextEditor::Cursor& b) {
+    return a.row < b.row || (a.row == b.row && a.col < b.col);
+}
+
+static bool sameCursor(const StudentTextEditor::Cursor& a, const StudentTextEditor::Cursor& b) {
+    return a.row == b.row && a.col == b.col;
+}
+
+void StudentTextEditor::addCursor(int row, int col) {
+    Cursor cursor;
+    cursor.row = row;
+    cursor.col = col;
+
+    // Keep the cursors in order, so a multi-cursor edit doesn't have to sort them
+    std::vector<Cursor>::iterator it = std::lower_bound(m_cursors.begin(), m_cursors.end(), cursor, cursorBefore);
+    if (it == m_cursors.end() || !sameCursor(*it, cursor)) {
+        m_cursors.insert(it, cursor);
+    }
+}
+
+void StudentTextEditor::clearCursors() {
+    m_cursors.clear();
+}
+
+const std::vector<StudentTextEditor::Cursor>& StudentTextEditor::cursors() const {
+    return m_cursors;
+}
+
+void StudentTextEditor::insertAtCursors(char ch) {
+    editAtCursors(EditJournal::MULTI_INSERT, ch);
+}
+
+void StudentTextEditor::delAtCursors() {
+    editAtCursors(EditJournal::MULTI_DELETE, 0);
+}
+
+void StudentTextEditor::backspaceAtCursors() {
+    editAtCursors(EditJournal::MULTI_BACKSPACE, 0);
+}
+
+// Time Complexity: O(K log K + K log N + L) for K cursors on lines with L characters in total
+void StudentTextEditor::editAtCursors(EditJournal::Command command, char ch) {
+    // The journal gets the cursors exactly as they are, since replaying the edit moves them onto the document the same way
+    std::string packed(m_cursors.size() * sizeof(Cursor), '\0');
+    if (!m_cursors.empty()) {
+        memcpy(&packed[0], m_cursors.data(), packed.length());
+    }
+    m_journal.appendCursors(m_row, m_col, packed);
+    m_journal.append(command, m_row, m_col, ch);
+    m_search.invalidate();
+    flushActiveLine();
+
+    // Move every cursor onto the document, then put them in order along with the main cursor
+    std::vector<Cursor> cursors = m_cursors;
+    Cursor main;
+    main.row = m_row;
+    main.col = m_col;
+    cursors.push_back(main);
+    for (Cursor& cursor : cursors) {
+        cursor.row = std::max(0, std::min(cursor.row, m_lines.size() - 1));
+        cursor.col = std::max(0, std::min(cursor.col, (int) m_lines.view(cursor.row).length()));
+    }
+    std::sort(cursors.begin(), cursors.end(), cursorBefore);
+    cursors.erase(std::unique(cursors.begin(), cursors.end(), sameCursor), cursors.end());
+    size_t mainIndex = std::lower_bound(cursors.begin(), cursors.end(), main, cursorBefore) - cursors.begin();
+
+    // Every edit is recorded in one group, so a single undo reverses all of them
+    StudentUndo* undo = dynamic_cast<StudentUndo*>(getUndo());
+    if (undo != nullptr) {
+        undo->beginGroup();
+    }
+
+    std::string_view inserted = ch == '\t' ? std::string_view("    ") : std::string_view(&ch, 1);
+    std::vector<Cursor> edits;      // Where each edit on the current line was made, in the line as it was
+    std::string erased;             // The characters erased on the current line
+    size_t i = 0;
+    while (i < cursors.size()) {
+        // Build the new version of each line that has a cursor in one pass and store it once
+        int row = cursors[i].row;
+        size_t end = i;
+        while (end < cursors.size() && cursors[end].row == row) {
+            end++;
+        }
+
+        std::string_view line = m_lines.view(row);
+        std::string newLine;
+        newLine.reserve(line.length() + (command == EditJournal::MULTI_INSERT ? (end - i) * inserted.length() : 0));
+        size_t copied = 0;      // How much of the old line has been copied (or erased) so far
+        int shift = 0;          // How far the edits so far have moved the rest of the line
+        edits.clear();
+        erased.clear();
+
+        for (; i < end; i++) {
+            int col = cursors[i].col;
+            if (command == EditJournal::MULTI_INSERT) {
+                newLine.append(line.substr(copied, col - copied));
+                newLine.append(inserted);
+                copied = col;
+                shift += inserted.length();
+                cursors[i].col = col + shift;
+            } else {
+                int pos = command == EditJournal::MULTI_DELETE ? col : col - 1;
+                if (pos < 0 || pos >= (int) line.length()) {
+                    cursors[i].col = col + shift;
+                    continue;
+                }
+                newLine.append(line.substr(copied, pos - copied));
+                copied = pos + 1;
+                erased += line[pos];
+                cursors[i].col = pos + shift;
+                shift--;
+            }
+
+            Cursor edit;
+            edit.row = row;
+            edit.col = col;
+            edits.push_back(edit);
+        }
+        if (edits.empty()) {
+            continue;
+        }
+
+        newLine.append(line.substr(copied));
+
+        // Undo is told about the edits from right to left: none of them moves the text to its left, so each one
+        // is recorded where it was actually made, and undoing them left to right puts every one back in place
+        for (int k = edits.size() - 1; k >= 0; k--) {
+            int col = edits[k].col;
+            if (command == EditJournal::MULTI_INSERT) {
+                if (undo != nullptr) {
+                    undo->submitText(row, col, inserted);
+                } else {
+                    getUndo()->submit(Undo::Action::INSERT, row, col + inserted.length(), ch);
+                }
+            } else {
+                int pos = command == EditJournal::MULTI_DELETE ? col : col - 1;
+                if (undo != nullptr) {
+                    undo->submitDeletedText(row, pos, std::string_view(&erased[k], 1));
+                } else {
+                    getUndo()->submit(Undo::Action::DELETE, row, pos, erased[k]);
+                }
+            }
+        }
+
+        m_lines.at(row) = std::move(newLine);
+        markChanged(row, 1, 1);
+    }
+
+    if (undo != nullptr) {
+        undo->endGroup();
+    }
+
+    // Cursors that ended up in the same place become one
+    m_row = cursors[mainIndex].row;
+    m_col = cursors[mainIndex].col;
+    m_currentLine = &m_lines.at(m_row);
+    m_cursors.clear();
+    for (const Cursor& cursor : cursors) {
+        if (!sameCursor(cursor, cursors[mainIndex]) && (m_cursors.empty() || !sameCursor(cursor, m_cursors.back()))) {
+            m_cursors.push_back(cursor);
+        }
+    }
+}
+
+const std::vector<LineDiff::Change>& StudentTextEditor::changedLines() {
+    return m_diff.changes(m_lines);
+}
+
+void StudentTextEditor::setWrapWidth(int width) {
+    m_layout.setWidth(width);
+}
+
+int StudentTextEditor::visualRowCount() {
+    return m_layout.size(m_lines);
+}
+
+void StudentTextEditor::getVisualPos(int& visualRow, int& visualCol) {
+    int wrap;
+    m_layout.locate(m_lines, m_row, m_col, wrap, visualCol);
+    visualRow = m_layout.visualRow(m_lines, m_row) + wrap;
+}
+
+int StudentTextEditor::getVisualRowViews(int startVisualRow, int numRows, std::vector<LineView>& views) {
+    if (startVisualRow < 0 || numRows < 0) {
+        return -1;
+    }
+
+    MappedFile::Pin pin;
+    return m_layout.getRows(m_lines, startVisualRow, numRows, views);
+}
+
 void StudentTextEditor::getPos(int& row, int& col) const {
     row = m_row;
     col = m_col;
@@ -250,63 +730,342 @@ int StudentTextEditor::getLines(int startRow, int numRows, std::vector<std::stri
 
     lines.clear();
 
-    // Have an iterator keep track of the line that startRow corresponds to
-    std::list<std::string>::const_iterator it = m_currentLine;
-    int numToAdvance = startRow - m_row;
-    std::advance(it, numToAdvance);
-
     // Visit numRows (if possible) at and after startRow and count how many have been visited
-    int numLinesVisited = 0;
-    for (int i = 0; i < numRows && it != m_lines.end(); i++) {
-        lines.push_back(*it);
-        it++;
-        numLinesVisited++;
+    // startRow is found in O(log N) time, so this doesn't depend on how far startRow is from the current row
+    return visitLines(startRow, numRows, [&lines](int, LineView line) {
+        lines.push_back(std::string(line.first));
+        lines.back().append(line.second);
+    });
+}
+
+int StudentTextEditor::getLineViews(int startRow, int numRows, std::vector<LineView>& views) const {
+    if (startRow < 0 || numRows < 0 || startRow > m_lines.size()) {
+        return -1;
     }
 
-    return numLinesVisited;
+    // clear() keeps the vector's capacity, so only the first few redraws ever allocate
+    views.clear();
+
+    // Lines kept compressed are read into a cache, which mustn't drop any of them while the rest are read
+    MappedFile::Pin pin;
+    return visitLines(startRow, numRows, [&views](int, LineView line) {
+        views.push_back(line);
+    });
 }
 
 void StudentTextEditor::undo() {
+    // StudentUndo can hand over a whole group of operations, which all have to be undone together
+    if (dynamic_cast<StudentUndo*>(getUndo()) != nullptr) {
+        undo(1);
+        return;
+    }
+
     int row, col, count;
     std::string text;
     Undo::Action action = getUndo()->get(row, col, count, text);
     if (action == Undo::ERROR) {
         return;
     }
+    m_journal.append(EditJournal::UNDO, m_row, m_col, 1);
+    m_search.invalidate();
+
+    // Undoing can change any line, so put the line being typed into back first
+    flushActiveLine();
+
+    int endRow, endCol;
+    applyAction(action, row, col, count, text, endRow, endCol);
+
+    // Update the editing row and col to where the undone operation started
+    m_row = row;
+    m_col = col;
+    m_currentLine = &m_lines.at(m_row);
+}
+
+void StudentTextEditor::undo(int count) {
+    // Only StudentUndo can hand over several operations at once
+    StudentUndo* studentUndo = dynamic_cast<StudentUndo*>(getUndo());
+    if (studentUndo == nullptr) {
+        for (int i = 0; i < count; i++) {
+            undo();
+        }
+        return;
+    }
+
+    std::vector<StudentUndo::Step> steps;
+    if (studentUndo->getMany(count, steps) == 0) {
+        return;
+    }
+    m_journal.append(EditJournal::UNDO, m_row, m_col, steps.size());
+    m_search.invalidate();
+
+    flushActiveLine();
+
+    MergedChange change;
+    bool haveChange = false;
+    for (const StudentUndo::Step& step : steps) {
+        // Splitting and joining are inserting and erasing a line break
+        MergedChange next;
+        next.insert = step.action == Undo::INSERT || step.action == Undo::SPLIT;
+        next.row = step.row;
+        next.col = step.col;
+        next.text = step.action == Undo::SPLIT || step.action == Undo::JOIN ? "\n" : step.text;
+        next.count = next.text.length();
+        findEnd(next.row, next.col, next.text, next.endRow, next.endCol);
+
+        if (haveChange && change.insert && next.insert) {
+            if (next.row == change.endRow && next.col == change.endCol) {
+                // Inserting right after the change's text adds to its end
+                change.text += next.text;
+                change.endRow = next.endRow;
+                change.endCol = next.endCol;
+                continue;
+            }
+            if (next.row == change.row && next.col == change.col) {
+                // Inserting right before the change's text adds to its front, which pushes its end along
+                change.front.append(next.text.rbegin(), next.text.rend());
+                if (change.endRow == change.row) {
+                    change.endCol += next.endCol - change.col;
+                }
+                change.endRow += next.endRow - change.row;
+                continue;
+            }
+        } else if (haveChange && !change.insert && !next.insert) {
+            if (next.row == change.row && next.col == change.col) {
+                // Erasing at the same place erases what came after the change's text
+                change.count += next.count;
+                continue;
+            }
+            if (next.endRow == change.row && next.endCol == change.col) {
+                // Erasing text that ends where the change starts erases what came before it
+                change.row = next.row;
+                change.col = next.col;
+                change.count += next.count;
+                continue;
+            }
+        }
+
+        // The operation isn't next to the change, so the change is as big as it gets
+        if (haveChange) {
+            applyMergedChange(change);
+        }
+        change = std::move(next);
+        haveChange = true;
+    }
+    applyMergedChange(change);
+
+    // Like undo, leave the cursor where the oldest undone operation started
+    m_row = steps.back().row;
+    m_col = steps.back().col;
+    m_currentLine = &m_lines.at(m_row);
+}
+
+int StudentTextEditor::checkpoint() const {
+    StudentUndo* studentUndo = dynamic_cast<StudentUndo*>(getUndo());
+    return studentUndo != nullptr ? studentUndo->depth() : 0;
+}
+
+void StudentTextEditor::undoToCheckpoint(int checkpoint) {
+    StudentUndo* studentUndo = dynamic_cast<StudentUndo*>(getUndo());
+    if (studentUndo != nullptr && studentUndo->depth() > checkpoint) {
+        undo(studentUndo->depth() - checkpoint);
+    }
+}
+
+void StudentTextEditor::redo() {
+    // Only StudentUndo remembers what was undone
+    StudentUndo* undo = dynamic_cast<StudentUndo*>(getUndo());
+    if (undo == nullptr) {
+        return;
+    }
+
+    int branch = undo->selectedBranch();
+    int row, col, count;
+    std::string text;
+    Undo::Action action = undo->redo(row, col, count, text);
+    if (action == Undo::ERROR) {
+        return;
+    }
+    // Remember which branch was redone, since the user could have picked any of them
+    m_journal.append(EditJournal::REDO, m_row, m_col, branch);
+    m_search.invalidate();
+
+    flushActiveLine();
+
+    // Redoing puts the cursor where it was right after the operation was first done
+    applyAction(action, row, col, count, text, m_row, m_col);
+
+    // A group is redone all at once
+    while (undo->redoContinuesGroup()) {
+        action = undo->redo(row, col, count, text);
+        applyAction(action, row, col, count, text, m_row, m_col);
+    }
+    m_currentLine = &m_lines.at(m_row);
+}
+
+void StudentTextEditor::applyMergedChange(MergedChange& change) {
+    if (!change.insert) {
+        eraseTextAt(change.row, change.col, change.count);
+        return;
+    }
+
+    // Put the front back in order in front of the rest of the text
+    std::string text(change.front.rbegin(), change.front.rend());
+    text += change.text;
+    int endRow, endCol;
+    insertTextAt(change.row, change.col, text, endRow, endCol);
+}
+
+int StudentTextEditor::replayJournal(const std::vector<EditJournal::Entry>& entries) {
+    int numReplayed = 0;
+    std::string query;      // The query of the last QUERY command, which the REPLACE command after it uses
+    for (const EditJournal::Entry& entry : entries) {
+        // Commands that edit at the cursor need the cursor back where it was when they were given
+        // (a replace-all doesn't, but it can move the cursor back if its line gets shorter)
+        // Cursor movements aren't recorded, so this is the only place the cursor's position comes from
+        if (entry.command != EditJournal::UNDO && entry.command != EditJournal::REDO
+            && entry.command != EditJournal::QUERY) {
+            if (entry.row < 0 || entry.row >= m_lines.size()) {
+                break;
+            }
+            if (entry.row != m_row) {
+                flushActiveLine();
+                m_row = entry.row;
+                m_currentLine = &m_lines.at(m_row);
+            }
+            if (entry.col < 0 || entry.col > currentLineLength()) {
+                break;
+            }
+            m_col = entry.col;
+        }
+
+        // Going through the same functions the user did rebuilds the undo history along with the text
+        switch (entry.command) {
+        case EditJournal::INSERT:
+            insert(entry.value);
+            break;
+        case EditJournal::DELETE:
+            del();
+            break;
+        case EditJournal::BACKSPACE:
+            backspace();
+            break;
+        case EditJournal::ENTER:
+            enter();
+            break;
+        case EditJournal::TEXT:
+            insertText(entry.text);
+            break;
+        case EditJournal::UNDO:
+            undo(entry.value);
+            break;
+        case EditJournal::REDO: {
+            StudentUndo* undo = dynamic_cast<StudentUndo*>(getUndo());
+            if (undo != nullptr) {
+                undo->selectBranch(entry.value);
+            }
+            redo();
+            break;
+        }
+        case EditJournal::QUERY:
+            query = entry.text;
+            break;
+        case EditJournal::REPLACE:
+            replaceAll(query, entry.text);
+            break;
+        case EditJournal::CURSORS:
+            m_cursors.resize(entry.text.length() / sizeof(Cursor));
+            if (!m_cursors.empty()) {
+                memcpy(m_cursors.data(), entry.text.data(), m_cursors.size() * sizeof(Cursor));
+            }
+            break;
+        case EditJournal::MULTI_INSERT:
+            insertAtCursors(entry.value);
+            break;
+        case EditJournal::MULTI_DELETE:
+            delAtCursors();
+            break;
+        case EditJournal::MULTI_BACKSPACE:
+            backspaceAtCursors();
+            break;
+        }
+        numReplayed++;
+    }
 
-    // Change the current line to point to wherever the undo needs to occur
-    int numToAdvance = row - m_row;
-    advance(m_currentLine, numToAdvance);
-    std::string& line = *m_currentLine;
+    return numReplayed;
+}
+
+void StudentTextEditor::applyAction(Undo::Action action, int row, int col, int count, const std::string& text,
+                                    int& endRow, int& endCol) {
+    endRow = row;
+    endCol = col;
 
     if (action == Undo::INSERT) {
         // Insert the characters back that were previously removed
-        line.insert(col, text);
+        insertTextAt(row, col, text, endRow, endCol);
     } else if (action == Undo::SPLIT) {
-        // Split two lines that were previously joined together
-        std::string postEnter = line.substr(col);
-        line.erase(col);
-
-        std::list<std::string>::iterator nextLine = m_currentLine;
-        nextLine++;
-
-        m_lines.insert(nextLine, postEnter);
+        // Splitting two lines is the same as inserting a line break between them
+        insertTextAt(row, col, "\n", endRow, endCol);
     } else if (action == Undo::DELETE) {
         // Erase the characters that were previously inserted
-        line.erase(col, count);
+        eraseTextAt(row, col, count);
     } else if (action == Undo::JOIN) {
-        // Join two lines that were previously split
-        std::list<std::string>::iterator nextLine = m_currentLine;
-        nextLine++;
+        // Joining two lines is the same as erasing the line break between them
+        eraseTextAt(row, col, 1);
+    }
+}
 
-        std::string newLine = line + *nextLine;
+void StudentTextEditor::insertTextAt(int row, int col, std::string_view text, int& endRow, int& endCol) {
+    std::string& line = m_lines.at(row);
 
-        m_lines.erase(nextLine);
-        m_currentLine = m_lines.erase(m_currentLine);
-        m_currentLine = m_lines.insert(m_currentLine, newLine);
+    size_t newline = text.find('\n');
+    if (newline == std::string_view::npos) {
+        line.insert(col, text.data(), text.length());
+        endRow = row;
+        endCol = col + text.length();
+        markChanged(row, 1, 1);
+        return;
     }
 
-    // Update the editing row and col
-    m_row = row;
-    m_col = col;
+    // The first line of text goes on the end of the line, and whatever was after col moves to after the last line
+    std::string rest = line.substr(col);
+    line.erase(col);
+    line.append(text.data(), newline);
+
+    // Split the rest of the text into lines once, then splice them all into the rope together
+    std::vector<std::string> newLines;
+    size_t start = newline + 1;
+    for (newline = text.find('\n', start); newline != std::string_view::npos; newline = text.find('\n', start)) {
+        newLines.push_back(std::string(text.substr(start, newline - start)));
+        start = newline + 1;
+    }
+    newLines.push_back(std::string(text.substr(start)));
+
+    endRow = row + newLines.size();
+    endCol = newLines.back().length();
+    newLines.back() += rest;
+
+    m_lines.insertLines(row + 1, newLines);
+    markChanged(row, 1, endRow - row + 1);
+}
+
+void StudentTextEditor::eraseTextAt(int row, int col, int count) {
+    // Find where the erased text ends; each line break crossed counts as one character
+    int endRow = row;
+    int endCol = col + count;
+    while (endCol > (int) m_lines.view(endRow).length()) {
+        endCol -= m_lines.view(endRow).length() + 1;
+        endRow++;
+    }
+
+    std::string& line = m_lines.at(row);
+    markChanged(row, endRow - row + 1, 1);
+    if (endRow == row) {
+        line.erase(col, count);
+        return;
+    }
+
+    // Keep the start of the first line and the end of the last one, and drop every line in between
+    line.erase(col);
+    line += m_lines.view(endRow).substr(endCol);
+    m_lines.eraseLines(row + 1, endRow - row);
 }
\ No newline at end of file
@@ -2,14 +2,29 @@
 #define STUDENTTEXTEDITOR_H_
 
 #include "TextEditor.h"
+#include "Undo.h"
+#include "LineRope.h"
+#include "GapBuffer.h"
+#include "LineView.h"
+#include "EditJournal.h"
+#include "AutoSaver.h"
+#include "TextSearch.h"
+#include "LineDiff.h"
+#include "WrapLayout.h"
 
 #include <string>
-#include <list>
-
-class Undo;
+#include <string_view>
+#include <vector>
 
 class StudentTextEditor : public TextEditor {
 public:
+    // How much was written by the last successful save and how long it took
+    struct SaveStats {
+        long long bytes;
+        double seconds;
+        double bytesPerSecond;
+    };
+
     StudentTextEditor(Undo* undo);
     ~StudentTextEditor();
     bool load(std::string file);
@@ -23,11 +38,154 @@ public:
     void getPos(int& row, int& col) const;
     int getLines(int startRow, int numRows, std::vector<std::string>& lines) const;
     void undo();
+    // Reapply the operation that was most recently undone
+    void redo();
+    // Undo the last count operations in one pass, merging operations on adjacent text into one change first,
+    // so undoing thousands of small operations costs about as much as the text they touched
+    void undo(int count);
+    // Return a point in the undo history that undoToCheckpoint can later return the document to
+    // (it counts the operations leading up to now, so it's only meaningful until something before it is undone)
+    int checkpoint() const;
+    // Undo every operation done since checkpoint returned checkpoint
+    void undoToCheckpoint(int checkpoint);
+
+    // Insert a block of text at the cursor in one pass, leaving the cursor just after it
+    // The text may span several lines; it's recorded as a single operation so one undo removes all of it
+    void insertText(std::string_view text);
+
+    // Find every occurrence of query in the document, in order (occurrences may overlap)
+    // If the document hasn't changed and query extends the last query, only the last matches are checked again
+    const std::vector<TextSearch::Match>& search(std::string_view query);
+    // Replace every occurrence of query with replacement, going left to right and skipping occurrences that
+    // overlap one that was just replaced; the replacement can't have a line break in it
+    // Each touched line is rewritten once, and a single undo reverses the whole thing
+    // Returns how many occurrences were replaced, or -1 if query or replacement isn't allowed
+    int replaceAll(std::string_view query, std::string_view replacement);
+
+    // A position in the document
+    struct Cursor {
+        int row;
+        int col;
+    };
+    // Add another cursor at row, col; the multi-cursor edits below apply at it as well as at the main cursor
+    // A cursor that's past the end of its line or of the document is moved back onto it when it's next used
+    void addCursor(int row, int col);
+    // Remove every cursor but the main one
+    void clearCursors();
+    // Return the extra cursors, sorted by position
+    const std::vector<Cursor>& cursors() const;
+    // Insert ch at every cursor, or delete the character after or before every cursor, all at once
+    // Lines are never split or joined: a cursor at the end of its line (for del) or the start (for backspace) is skipped
+    // Each touched line is rewritten once, and a single undo reverses the edit at every cursor
+    void insertAtCursors(char ch);
+    void delAtCursors();
+    void backspaceAtCursors();
+
+    // Return every run of lines that's different than in the file as it was last loaded or saved, in order,
+    // for marking modified lines in the gutter; the results stay valid until the next call
+    // Only the lines edited since the last call are diffed again, so this is cheap enough to call on every redraw
+    const std::vector<LineDiff::Change>& changedLines();
+
+    // Soft-wrap lines into visual rows at most width columns wide from now on, or stop wrapping them if width is 0
+    // The layout is kept up to date as lines are edited, so finding any visual row takes O(log N) time
+    void setWrapWidth(int width);
+    // Return the number of visual rows the document takes up
+    int visualRowCount();
+    // Find which visual row the cursor is on, and its column within that row
+    void getVisualPos(int& visualRow, int& visualCol);
+    // Like getLineViews, but for up to numRows visual rows starting at startVisualRow
+    int getVisualRowViews(int startVisualRow, int numRows, std::vector<LineView>& views);
+
+    // Like getLines, but fill views with read-only views of the lines instead of copies of them
+    // The views stay valid until the next change to the document, and reusing the same vector
+    // between redraws means drawing the screen allocates nothing once the vector has grown large enough
+    // The line being typed into is viewed in place in its gap buffer, so its view is in two parts
+    int getLineViews(int startRow, int numRows, std::vector<LineView>& views) const;
+    // Call visit(row, text) for up to numRows lines starting at startRow, returning how many were visited
+    // text is a LineView, which for the line being typed into is in two parts
+    template <typename Visitor>
+    int visitLines(int startRow, int numRows, Visitor visit) const;
+
+    // Return a copy of the document as it is right now, for reading on another thread while the editor keeps going
+    // The copy shares every line with the editor, so making it only costs putting back the line being typed into
+    LineRope snapshot();
+
+    // Choose whether load keeps the lines of the files it loads compressed in memory instead of mapped,
+    // which uses far less memory for huge files that are mostly read; this takes effect on the next load
+    // Views of lines that haven't been edited then point into a cache of decompressed blocks, which keeps every
+    // block one call to getLineViews or getVisualRowViews reads, but can drop them once later calls read
+    // lines in MappedFile::CACHE_BLOCKS other blocks; so views are valid until then or the next change
+    void setCompressedStorage(bool compress);
+
+    // Return statistics about the last successful save
+    const SaveStats& lastSaveStats() const;
+
+    // Write a snapshot of the document to file on a background thread, returning right away
+    // This is meant for a recovery copy rather than the document's own file: it doesn't count as saving,
+    // so the journal keeps every edit since the last real save. Requests that pile up are coalesced
+    void autosave(std::string file);
+    // Return what autosave has done so far
+    AutoSaver::Stats autosaveStats() const;
 private:
     int m_row;  // row of current editing position
     int m_col;  // col of current editing position
-    std::list<std::string> m_lines;     // STL list container for all lines in the text editor
-    std::list<std::string>::iterator m_currentLine;     // list iterator pointing to current line being edited
+    LineRope m_lines;   // Balanced rope of all lines in the text editor, indexed by row
+    // Pointer to the current line being edited (always the line at m_row)
+    // Its node may be shared with a snapshot, so it's only written through right after m_lines.at returns it
+    std::string* m_currentLine;
+    // The line being typed into lives in a gap buffer until the cursor leaves it, and its copy in
+    // m_lines is stale until then; readers (the diff and the layout too) read it from the gap buffer
+    GapBuffer m_activeLine;
+    int m_activeRow;    // Row held in m_activeLine, or -1 if m_lines is up to date
+    SaveStats m_lastSave;
+    // Every edit since the document last matched a file on disk, so they can be recovered after a crash
+    EditJournal m_journal;
+    AutoSaver m_autoSaver;
+    TextSearch m_search;    // Remembers the last search's matches until the document changes
+    std::vector<Cursor> m_cursors;  // Cursors besides the main one, sorted by position
+    LineDiff m_diff;    // Which lines were edited since the last load or save, and how they differ from it
+    bool m_compressLines;   // Whether load keeps lines compressed rather than mapped
+    WrapLayout m_layout;    // How many visual rows each line wraps into
+
+    // Move the current line into the gap buffer (if it isn't there already) so it can be typed into
+    void activateCurrentLine();
+    // Copy the gap buffer back into m_lines
+    void flushActiveLine();
+    // Return the length of the current line, wherever it's being held
+    int currentLineLength() const;
+    // Tell everything that tracks lines that count rows starting at row were replaced by newCount rows
+    void markChanged(int row, int count, int newCount);
+    // Tell everything that tracks lines that inserted characters replaced erased ones at col in the line at row
+    void markEdited(int row, int col, int erased, int inserted);
+    // Insert text (which may contain newlines) at row, col, storing where the text ends in endRow, endCol
+    void insertTextAt(int row, int col, std::string_view text, int& endRow, int& endCol);
+    // Erase count characters starting at row, col, where every line break crossed counts as a character
+    void eraseTextAt(int row, int col, int count);
+    // Make one change that undo(count) put together
+    struct MergedChange;
+    void applyMergedChange(MergedChange& change);
+    // Apply a MULTI_INSERT, MULTI_DELETE, or MULTI_BACKSPACE command at every cursor
+    void editAtCursors(EditJournal::Command command, char ch);
+    // Redo the commands recovered from a journal, returning how many of them could be redone
+    int replayJournal(const std::vector<EditJournal::Entry>& entries);
+    // Apply an action returned by undo or redo to the document, storing where the cursor ends up in endRow, endCol
+    void applyAction(Undo::Action action, int row, int col, int count, const std::string& text, int& endRow, int& endCol);
 };
 
+template <typename Visitor>
+int StudentTextEditor::visitLines(int startRow, int numRows, Visitor visit) const {
+    if (startRow < 0 || numRows < 0 || startRow > m_lines.size()) {
+        return -1;
+    }
+
+    int numLinesVisited = 0;
+    for (LineRope::Iterator it = m_lines.iterate(startRow); numLinesVisited < numRows && !it.done(); it.next()) {
+        int row = startRow + numLinesVisited;
+        visit(row, row == m_activeRow ? m_activeLine.view() : LineView(it.view()));
+        numLinesVisited++;
+    }
+
+    return numLinesVisited;
+}
+
 #endif // STUDENTTEXTEDITOR_H_
\ No newline at end of file
@@ -1,131 +1,436 @@
 #include "StudentUndo.h"
 
-#include <stack>
+#include <string>
+#include <string_view>
+#include <vector>
 
 Undo* createUndo() {
     return new StudentUndo;
 }
 
+StudentUndo::StudentUndo() : m_spillFile(nullptr), m_memoryBudget(0) {
+    clear();
+}
+
+StudentUndo::~StudentUndo() {
+    // A temporary file is deleted automatically when it's closed
+    if (m_spillFile != nullptr) {
+        std::fclose(m_spillFile);
+    }
+}
+
 void StudentUndo::submit(const Undo::Action action, int row, int col, char ch) {
-    // If there are no operations add one for the character
-    if (m_operations.empty()) {
-        m_operations.push(createOperation(action, row, col, ch));
+    // A tab is inserted as 4 spaces, so that's what has to be deleted again to undo it
+    std::string_view text = ch == '\t' && action == INSERT ? std::string_view("    ") : std::string_view(&ch, 1);
+
+    // If there's no operation to batch with add one for the character
+    if (!canBatch()) {
+        if (action == INSERT) {
+            pushOperation(action, row, col - text.length(), text);
+        } else if (action == DELETE) {
+            pushOperation(action, row, col, text);
+        } else {
+            pushOperation(action, row, col, std::string_view());
+        }
         return;
     }
 
-    Operation*& lastOp = m_operations.top();
+    Operation& lastOp = m_operations[m_current];
 
     if (action == DELETE) {
         // Batch together delete operations that occur consecutively
-        if (lastOp->action == DELETE && row == lastOp->row) {
-            if (col == lastOp->col) {
-                lastOp->chars.push_front(ch);   // Push delete operations to the front of the last operation's chars
-            } else if (col + 1 == lastOp->col) {
-                lastOp->col--;
-                lastOp->chars.push_back(ch);    // Push backspace operations to the back of the last operation's chars
-            }
+        if (lastOp.action == DELETE && !lastOp.block && row == lastOp.row && col == lastOp.col) {
+            // Deleting at the same col adds to the end of the deleted text
+            m_chars += ch;
+            lastOp.count++;
+        } else if (lastOp.action == DELETE && !lastOp.block && row == lastOp.row && col + 1 == lastOp.col) {
+            // Backspacing adds to the front of the deleted text
+            m_frontChars += ch;
+            lastOp.col--;
+            lastOp.count++;
         } else {
-            m_operations.push(createOperation(action, row, col, ch));
+            pushOperation(action, row, col, text);
         }
     } else if (action == INSERT) {
-        // Batch together insert operations that occur consecutively
-        if (lastOp->action == INSERT && row == lastOp->row) {
-            if (col - 1 == lastOp->col) {
-                // Single characters are easy, so just push them to the back of the last operation's chars
-                lastOp->col++;
-                lastOp->chars.push_back(ch);
-            } else if (ch == '\t' && col - 4 == lastOp->col) {
-                // Account for tabs because they take up 4 space characters
-                lastOp->col += 4;
-                for (int i = 0; i < 4; i++) {
-                    lastOp->chars.push_back(' ');
-                }
-            } else {
-                m_operations.push(createOperation(action, row, col, ch));
-            }
+        // Batch together insert operations that occur consecutively; col is where the cursor ended up,
+        // so the character(s) were typed right after the last operation if they end text.length() past it
+        if (lastOp.action == INSERT && !lastOp.block && row == lastOp.row
+            && col - (int) text.length() == lastOp.col + lastOp.count) {
+            m_chars += text;
+            lastOp.count += text.length();
         } else {
-            m_operations.push(createOperation(action, row, col, ch));
+            pushOperation(action, row, col - text.length(), text);
         }
     } else {
-        m_operations.push(createOperation(action, row, col, ch));
+        pushOperation(action, row, col, std::string_view());
     }
 }
 
 StudentUndo::Action StudentUndo::get(int& row, int& col, int& count, std::string& text) {
-    if (m_operations.empty()) {
+    // Once everything in memory has been undone, keep going with what was spilled to disk
+    if (m_current == 0 && !pageIn()) {
         return Action::ERROR;
     }
 
-    Operation* operation = m_operations.top();
-    m_operations.pop();
+    sealLastOperation();
+    const Operation& operation = m_operations[m_current];
 
-    row = operation->row;
-    col = operation->col;
-    count = operation->chars.size();
+    row = operation.row;
+    col = operation.col;
+    count = operation.count;
+    text.assign(m_chars, operation.start, operation.count);
 
-    Action action;
-    switch (operation->action) {
-    case INSERT:
-        while (!operation->chars.empty()) {
-            // Create a string out of the characters that were batched together
-            char ch = operation->chars.back();
-            operation->chars.pop_back();
-
-            // Account for tabs because they take up 4 space characters
-            if (ch == '\t') {
-                text += std::string(4, ' ');
-                col -= 4;
-            } else {
-                text += ch;
-                col--;
-            }
-        }
+    // Step back to the parent, remembering which way to go if the user redoes
+    m_operations[operation.parent].redoChild = m_current;
+    m_current = operation.parent;
+    m_depth--;
+    m_canBatch = false;
 
+    switch (operation.action) {
+    case INSERT:
         // The opposite of insertion is deletion, so the action here is to delete the characters that were inserted
-        action = DELETE;
-        break;
+        return DELETE;
     case SPLIT:
         // The opposite of splitting is joining, so the action here is to join the lines that were split
-        action = JOIN;
-        break;
+        return JOIN;
     case DELETE:
-        // Create a string out of the characters that were batched together
-        while (!operation->chars.empty()) {
-            char ch = operation->chars.back();
-            operation->chars.pop_back();
-            text += ch;
-        }
-
         // The opposite of deletion is insertion, so the action here is to insert the characters that were deleted
-        action = INSERT;
-        break;
+        return INSERT;
     case JOIN:
         // The opposite of joining is splitting, so the action here is to split the lines that were joined
-        action = SPLIT;
-        break;
+        return SPLIT;
+    default:
+        return ERROR;
     }
-
-    // Remember to delete the operation to free up memory
-    delete operation;
-    return action;
 }
 
 void StudentUndo::clear() {
-    // Pop off each Operation* and delete it to free space
-    while (!m_operations.empty()) {
-        Operation* op = m_operations.top();
-        m_operations.pop();
+    // Start over with just the operation standing for the original state
+    Operation root;
+    root.action = ERROR;
+    root.row = 0;
+    root.col = 0;
+    root.start = 0;
+    root.count = 0;
+    root.block = false;
+    root.grouped = false;
+    root.parent = -1;
+    root.firstChild = -1;
+    root.nextSibling = -1;
+    root.redoChild = -1;
+
+    m_operations.clear();
+    m_operations.push_back(root);
+    m_current = 0;
+    m_depth = 0;
+    m_canBatch = false;
+    m_chars.clear();
+    m_frontChars.clear();
+    m_grouping = false;
+    m_groupStarted = false;
+    m_spilled.clear();  // The spill file's space is simply reused from the start
+}
+
+void StudentUndo::submitText(int row, int col, std::string_view text) {
+    pushOperation(INSERT, row, col, text);
+    m_operations[m_current].block = true;
+}
+
+void StudentUndo::submitDeletedText(int row, int col, std::string_view text) {
+    pushOperation(DELETE, row, col, text);
+    m_operations[m_current].block = true;
+}
+
+void StudentUndo::beginGroup() {
+    m_grouping = true;
+    m_groupStarted = false;
+}
+
+void StudentUndo::endGroup() {
+    m_grouping = false;
+}
+
+bool StudentUndo::redoContinuesGroup() const {
+    int next = m_operations[m_current].redoChild;
+    return next >= 0 && m_operations[next].grouped;
+}
+
+int StudentUndo::getMany(int maxCount, std::vector<Step>& steps) {
+    int numUndone = 0;
+    bool inGroup = false;
+    while (numUndone < maxCount || inGroup) {
+        // Look at the operation before undoing it, to see whether its group goes on before it
+        if (m_current == 0 && !pageIn()) {
+            break;
+        }
+        inGroup = m_operations[m_current].grouped;
 
-        delete op;
+        Step step;
+        step.action = get(step.row, step.col, step.count, step.text);
+        if (step.action == ERROR) {
+            break;
+        }
+        steps.push_back(std::move(step));
+        numUndone++;
+    }
+    return numUndone;
+}
+
+int StudentUndo::depth() const {
+    return m_depth;
+}
+
+StudentUndo::Action StudentUndo::redo(int& row, int& col, int& count, std::string& text) {
+    int next = m_operations[m_current].redoChild;
+    if (next < 0) {
+        return Action::ERROR;
     }
+
+    sealLastOperation();
+    m_current = next;
+    m_depth++;
+    m_canBatch = false;
+
+    const Operation& operation = m_operations[m_current];
+    row = operation.row;
+    col = operation.col;
+    count = operation.count;
+    text.assign(m_chars, operation.start, operation.count);
+
+    return operation.action;
 }
 
-// Create a pointer to an Operation to keep track of undo data
-StudentUndo::Operation* StudentUndo::createOperation(Undo::Action action, int row, int col, char ch) {
-    Operation* op = new Operation;
-    op->action = action;
-    op->row = row;
-    op->col = col;
-    op->chars.push_back(ch);
-    return op;
+int StudentUndo::branchCount() const {
+    int count = 0;
+    for (int child = m_operations[m_current].firstChild; child >= 0; child = m_operations[child].nextSibling) {
+        count++;
+    }
+    return count;
+}
+
+void StudentUndo::selectBranch(int branch) {
+    int child = m_operations[m_current].firstChild;
+    for (int i = 0; i < branch && child >= 0; i++) {
+        child = m_operations[child].nextSibling;
+    }
+
+    if (child >= 0) {
+        m_operations[m_current].redoChild = child;
+    }
+}
+
+int StudentUndo::selectedBranch() const {
+    int branch = 0;
+    for (int child = m_operations[m_current].firstChild; child >= 0; child = m_operations[child].nextSibling) {
+        if (child == m_operations[m_current].redoChild) {
+            return branch;
+        }
+        branch++;
+    }
+    return 0;
+}
+
+void StudentUndo::setMemoryBudget(size_t bytes) {
+    m_memoryBudget = bytes;
+    enforceBudget();
+}
+
+size_t StudentUndo::memoryUsage() const {
+    return m_operations.size() * sizeof(Operation) + m_chars.length() + m_frontChars.length();
+}
+
+void StudentUndo::pushOperation(Undo::Action action, int row, int col, std::string_view text) {
+    // The newest operation can't grow anymore once there's an operation newer than it
+    sealLastOperation();
+
+    Operation op;
+    op.action = action;
+    op.row = row;
+    op.col = col;
+    op.start = m_chars.length();
+    op.count = text.length();
+    // Nothing is batched into a group's operations, since they have to stay exactly as the group made them
+    op.block = m_grouping;
+    op.grouped = m_grouping && m_groupStarted;
+    if (m_grouping) {
+        m_groupStarted = true;
+    }
+
+    // The new operation becomes the parent's most recent child, and the one redo goes to from there
+    Operation& parent = m_operations[m_current];
+    op.parent = m_current;
+    op.firstChild = -1;
+    op.nextSibling = parent.firstChild;
+    op.redoChild = -1;
+    parent.firstChild = m_operations.size();
+    parent.redoChild = m_operations.size();
+
+    m_current = m_operations.size();
+    m_depth++;
+    m_operations.push_back(op);
+    m_chars += text;
+    m_canBatch = true;
+
+    // Checking here is enough, since batching can only grow the current operation, which is never spilled
+    enforceBudget();
+}
+
+bool StudentUndo::canBatch() const {
+    return m_canBatch;
+}
+
+void StudentUndo::sealLastOperation() {
+    if (m_frontChars.empty()) {
+        return;
+    }
+
+    // The last character backspaced over is the first character of the deleted text
+    Operation& lastOp = m_operations.back();
+    m_chars.insert(m_chars.begin() + lastOp.start, m_frontChars.rbegin(), m_frontChars.rend());
+    m_frontChars.clear();
+}
+
+void StudentUndo::enforceBudget() {
+    if (m_memoryBudget == 0 || memoryUsage() <= m_memoryBudget) {
+        return;
+    }
+
+    // Find the chain of operations that led to the current state, newest first
+    std::vector<int> path;
+    for (int op = m_current; op != 0; op = m_operations[op].parent) {
+        path.push_back(op);
+    }
+
+    // The current operation might still be growing, so there have to be at least two to spill anything
+    if (path.size() < 2) {
+        return;
+    }
+
+    if (m_spillFile == nullptr) {
+        m_spillFile = std::tmpfile();
+        if (m_spillFile == nullptr) {
+            return;     // Nowhere to spill to, so just keep everything in memory
+        }
+    }
+    sealLastOperation();
+
+    // Spill the oldest half of the chain, oldest first, with each record's start relative to the segment
+    int numOperations = path.size() / 2;
+    std::vector<Operation> records;
+    std::string chars;
+    for (int i = path.size() - 1; i >= (int) path.size() - numOperations; i--) {
+        Operation op = m_operations[path[i]];
+        op.start = chars.length();
+        chars.append(m_chars, m_operations[path[i]].start, op.count);
+        records.push_back(op);
+    }
+
+    SpilledSegment segment;
+    segment.offset = m_spilled.empty() ? 0 : m_spilled.back().offset
+        + m_spilled.back().numOperations * sizeof(Operation) + m_spilled.back().numChars;
+    segment.numOperations = numOperations;
+    segment.numChars = chars.length();
+
+    if (std::fseek(m_spillFile, segment.offset, SEEK_SET) != 0
+        || std::fwrite(records.data(), sizeof(Operation), numOperations, m_spillFile) != (size_t) numOperations
+        || std::fwrite(chars.data(), 1, chars.length(), m_spillFile) != chars.length()) {
+        return;
+    }
+    m_spilled.push_back(segment);
+
+    // The state after the last spilled operation becomes the new starting state, so only the
+    // operations done after it are kept; find them all and number them in their old order,
+    // so that the newest operation (if it's kept) stays at the end
+    const int KEPT = -2;
+    int newRoot = path[path.size() - numOperations];
+    std::vector<int> newIndex(m_operations.size(), -1);
+    std::vector<int> toVisit(1, newRoot);
+    while (!toVisit.empty()) {
+        int op = toVisit.back();
+        toVisit.pop_back();
+        for (int child = m_operations[op].firstChild; child >= 0; child = m_operations[child].nextSibling) {
+            newIndex[child] = KEPT;
+            toVisit.push_back(child);
+        }
+    }
+
+    int numKept = 1;
+    newIndex[newRoot] = 0;
+    for (size_t op = 0; op < m_operations.size(); op++) {
+        if (newIndex[op] == KEPT) {
+            newIndex[op] = numKept++;
+        }
+    }
+
+    std::vector<Operation> operations(numKept);
+    std::string keptChars;
+    operations[0] = m_operations[0];
+    for (size_t op = 0; op < m_operations.size(); op++) {
+        if (newIndex[op] < 0) {
+            continue;
+        }
+
+        const Operation& old = m_operations[op];
+        Operation& kept = operations[newIndex[op]];
+        if ((int) op != newRoot) {
+            kept = old;
+            kept.parent = newIndex[old.parent];
+            kept.nextSibling = old.nextSibling >= 0 ? newIndex[old.nextSibling] : -1;
+            kept.start = keptChars.length();
+            keptChars.append(m_chars, old.start, old.count);
+        }
+
+        // The new starting state takes over the children of the last spilled operation
+        kept.firstChild = old.firstChild >= 0 ? newIndex[old.firstChild] : -1;
+        kept.redoChild = old.redoChild >= 0 ? newIndex[old.redoChild] : -1;
+    }
+
+    m_operations.swap(operations);
+    m_chars.swap(keptChars);
+    m_current = newIndex[m_current];
+}
+
+bool StudentUndo::pageIn() {
+    if (m_spilled.empty()) {
+        return false;
+    }
+
+    // Read the chain back, then put it between the starting state and everything that was done after it
+    SpilledSegment segment = m_spilled.back();
+    std::vector<Operation> records(segment.numOperations);
+    std::string chars(segment.numChars, '\0');
+
+    if (std::fseek(m_spillFile, segment.offset, SEEK_SET) != 0
+        || std::fread(records.data(), sizeof(Operation), segment.numOperations, m_spillFile) != (size_t) segment.numOperations
+        || std::fread(&chars[0], 1, segment.numChars, m_spillFile) != (size_t) segment.numChars) {
+        // The history can't be recovered, so there's nothing more to undo
+        m_spilled.clear();
+        return false;
+    }
+    m_spilled.pop_back();
+
+    sealLastOperation();
+    int first = m_operations.size();
+    int last = first + segment.numOperations - 1;
+
+    for (int i = 0; i < segment.numOperations; i++) {
+        Operation op = records[i];
+        op.start += m_chars.length();
+        op.parent = i == 0 ? 0 : first + i - 1;
+        op.nextSibling = -1;
+        op.firstChild = i < segment.numOperations - 1 ? first + i + 1 : m_operations[0].firstChild;
+        op.redoChild = i < segment.numOperations - 1 ? first + i + 1 : m_operations[0].redoChild;
+        m_operations.push_back(op);
+    }
+    m_chars += chars;
+
+    for (int child = m_operations[0].firstChild; child >= 0; child = m_operations[child].nextSibling) {
+        m_operations[child].parent = last;
+    }
+    m_operations[0].firstChild = first;
+    m_operations[0].redoChild = first;
+    m_current = last;
+    m_canBatch = false;
+
+    return true;
 }
\ No newline at end of file
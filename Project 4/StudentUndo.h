@@ -3,25 +3,121 @@
 
 #include "Undo.h"
 
-#include <stack>
-#include <list>
+#include <string>
+#include <string_view>
+#include <vector>
+#include <cstdio>
+#include <cstddef>
 
 class StudentUndo : public Undo {
 public:
+    StudentUndo();
+    ~StudentUndo();
     void submit(Undo::Action action, int row, int col, char ch = 0);
     Action get(int& row, int& col, int& count, std::string& text);
     void clear();
+    // Record that a whole block of text (possibly spanning several lines) was inserted at once at row, col
+    // Undoing it deletes the entire block in one step
+    void submitText(int row, int col, std::string_view text);
+    // Record that a whole block of text was deleted at once at row, col
+    // Undoing it inserts the entire block back in one step
+    void submitDeletedText(int row, int col, std::string_view text);
+
+    // Everything submitted between beginGroup and endGroup is undone (and redone) together as one step
+    void beginGroup();
+    void endGroup();
+    // Return whether the operation redo would apply next is in the same group as the one it just applied
+    bool redoContinuesGroup() const;
+
+    // What get returns for one operation
+    struct Step {
+        Undo::Action action;
+        int row;
+        int col;
+        int count;
+        std::string text;
+    };
+    // Undo up to maxCount operations at once, adding what get would have returned for each of them to steps
+    // (newest first), and return how many were undone
+    // A group is never left partly undone, so this goes past maxCount if it has to finish one
+    int getMany(int maxCount, std::vector<Step>& steps);
+    // Return how many operations lead up to the current state, including ones spilled to disk
+    int depth() const;
+
+    // Step forward again through the operation that was most recently undone from the current state
+    // Returns the action to apply (the same one that was originally submitted), or ERROR if there's nothing to redo
+    Action redo(int& row, int& col, int& count, std::string& text);
+    // Return how many different operations were done from the current state (and so could be redone)
+    int branchCount() const;
+    // Choose which of those operations redo applies, where 0 is the most recent one
+    void selectBranch(int branch);
+    // Return which of those operations redo will apply, counting the same way as selectBranch
+    int selectedBranch() const;
+
+    // Limit how many bytes of undo history are kept in memory (0 means no limit)
+    // Once the limit is passed, the oldest half of the operations leading up to the current state are written
+    // out to a temporary file, and they're only read back in if the user undoes everything newer than them
+    // Branches that split off before the spilled operations can't be redone anymore and are dropped
+    void setMemoryBudget(size_t bytes);
+    // Return how many bytes of undo history are currently in memory
+    size_t memoryUsage() const;
 private:
     // We need to keep track of the things that are stored when a user decides to undo something
+    // Operations form a tree: undoing moves to an operation's parent, and doing something new after undoing
+    // starts a new branch instead of throwing the undone operations away. Every operation is a fixed-size
+    // record in one vector, and the characters of all of them are packed together in m_chars, so typing a
+    // character costs one byte and stepping through the tree never allocates
     struct Operation {
         Undo::Action action;
         int row;
-        int col;
-        std::list<char> chars;  // Popping these off yields the text that was undone
+        int col;        // Where the operation's text starts in its row
+        int start;      // Index in m_chars of the operation's first character
+        int count;      // Number of characters in the operation
+        bool block;     // Whether this is a block of text submitted all at once (and so can't be batched with)
+        bool grouped;   // Whether this is in the same group as its parent, so undoing it has to undo the parent too
+        int parent;         // The operation this one was done after
+        int firstChild;     // The most recent operation done after this one, or -1 if there isn't one
+        int nextSibling;    // The next older operation done after the same parent, or -1
+        int redoChild;      // The child that redo applies, or -1 if there isn't one
+    };
+    std::vector<Operation> m_operations;    // m_operations[0] stands for the state before any operation in memory
+    int m_current;      // The most recent operation that's applied to the document
+    int m_depth;        // Number of operations from the start of the history to m_current
+    // Whether m_current was the last operation submitted, with nothing undone or redone since, so the next
+    // keystroke can grow it; an operation that's been redone onto is never grown, since that would make
+    // undoing it again take away more than the redo put back
+    bool m_canBatch;
+    std::string m_chars;
+    bool m_grouping;        // Whether operations are being grouped
+    bool m_groupStarted;    // Whether the current group has an operation yet
+
+    // The newest operation's characters are always at the end of m_chars, so batching a character
+    // onto the end of its text is just an append. Backspacing adds characters to the front of its text
+    // instead, so those wait here (in the order they were deleted) until the operation is done growing
+    std::string m_frontChars;
+
+    // Operations that were written out to the temporary file, oldest first; each segment is a chain of
+    // operations, stored as their records followed by their characters
+    struct SpilledSegment {
+        long offset;        // Where the segment starts in m_spillFile
+        int numOperations;
+        int numChars;
     };
-    std::stack<Operation*> m_operations;
+    std::vector<SpilledSegment> m_spilled;
+    std::FILE* m_spillFile;     // Created the first time something needs to be spilled
+    size_t m_memoryBudget;
 
-    Operation* createOperation(Undo::Action action, int row, int col, char ch);
+    // Add an operation after the current one whose text is text, and make it the current one
+    void pushOperation(Undo::Action action, int row, int col, std::string_view text);
+    // Return whether the current operation is the newest one and can still be batched with
+    // (the newest operation is always the last one in m_operations, and its characters end m_chars)
+    bool canBatch() const;
+    // Move any characters waiting in m_frontChars into the newest operation's text
+    void sealLastOperation();
+    // Spill the oldest operations to disk if the history has grown past the memory budget
+    void enforceBudget();
+    // Read the most recently spilled segment back into memory, returning false if there isn't one
+    bool pageIn();
 };
 
 #endif // STUDENTUNDO_H_
\ No newline at end of file
@@ -0,0 +1,127 @@
+#include "TextSearch.h"
+#include <string>
+#include <string_view>
+#include <vector>
+#include <cstring>
+
+// A narrowing walk steps through at most this many lines to get to the next match's line, and starts a new
+// iterator there (which costs O(log N)) if it's further away than that
+const int MAX_STEPS = 64;
+// The most matches kept for queries before the latest one, so that backspacing can reuse them
+const size_t MAX_KEPT_MATCHES = 1 << 20;
+
+TextSearch::TextSearch() {}
+
+const std::vector<TextSearch::Match>& TextSearch::search(const LineRope& lines, std::string_view query) {
+    // Matches never span lines, so a query with a line break (or no query at all) matches nothing
+    if (query.empty() || query.find('\n') != std::string_view::npos) {
+        return m_noMatches;
+    }
+
+    // Drop the results of queries that this one doesn't extend
+    while (!m_queries.empty() && query.substr(0, m_queries.back().length()) != m_queries.back()) {
+        m_queries.pop_back();
+        m_results.pop_back();
+    }
+
+    if (!m_queries.empty() && m_queries.back().length() == query.length()) {
+        return m_results.back();
+    }
+
+    // Walking the previous matches in order is never slower than scanning every line again, since a scan
+    // walks the same lines and compares at least as many places
+    std::vector<Match> matches;
+    if (m_queries.empty()) {
+        scan(lines, query, matches);
+    } else {
+        narrow(lines, query, m_results.back(), matches);
+    }
+
+    m_queries.push_back(std::string(query));
+    m_results.push_back(std::move(matches));
+
+    // Shorter queries tend to have the most matches, so keep the ones nearest this query (which backspace gets
+    // back to first) up to the limit, and let backspacing past those scan again
+    size_t kept = 0;
+    size_t first = m_results.size() - 1;
+    while (first > 0 && kept + m_results[first - 1].size() <= MAX_KEPT_MATCHES) {
+        first--;
+        kept += m_results[first].size();
+    }
+    m_queries.erase(m_queries.begin(), m_queries.begin() + first);
+    m_results.erase(m_results.begin(), m_results.begin() + first);
+    return m_results.back();
+}
+
+void TextSearch::invalidate() {
+    m_queries.clear();
+    m_results.clear();
+}
+
+size_t TextSearch::find(std::string_view text, std::string_view pattern, size_t from) {
+    if (pattern.empty()) {
+        return from <= text.length() ? from : std::string_view::npos;
+    }
+    if (pattern.length() > text.length()) {
+        return std::string_view::npos;
+    }
+
+    // The pattern can't start any later than this
+    const char* last = text.data() + text.length() - pattern.length();
+    const char* pos = text.data() + from;
+    while (pos <= last) {
+        pos = static_cast<const char*>(memchr(pos, pattern[0], last - pos + 1));
+        if (pos == nullptr) {
+            break;
+        }
+        if (memcmp(pos + 1, pattern.data() + 1, pattern.length() - 1) == 0) {
+            return pos - text.data();
+        }
+        pos++;
+    }
+
+    return std::string_view::npos;
+}
+
+// Time Complexity: O(B) for a document of B bytes when the query's first character is rare,
+// and O(B * Q) at worst for a query of length Q
+void TextSearch::scan(const LineRope& lines, std::string_view query, std::vector<Match>& matches) {
+    int row = 0;
+    for (LineRope::Iterator it = lines.iterate(0); !it.done(); it.next(), row++) {
+        std::string_view line = it.view();
+        for (size_t col = find(line, query); col != std::string_view::npos; col = find(line, query, col + 1)) {
+            Match match;
+            match.row = row;
+            match.col = col;
+            matches.push_back(match);
+        }
+    }
+}
+
+// Time Complexity: O(M * Q + min(N, M log N)) for M previous matches in N lines, since their lines are walked in order
+void TextSearch::narrow(const LineRope& lines, std::string_view query, const std::vector<Match>& previous,
+                        std::vector<Match>& matches) {
+    // The matches are in order, so an iterator walks forward from each match's line to the next one's rather
+    // than looking every line up from the root of the rope, and a new one is only started past a long gap
+    size_t i = 0;
+    while (i < previous.size()) {
+        int row = previous[i].row;
+        LineRope::Iterator it = lines.iterate(row);
+        while (true) {
+            // Matches on the same row are next to each other, so each row only has to be read once
+            std::string_view line = it.view();
+            for (; i < previous.size() && previous[i].row == row; i++) {
+                if (line.substr(previous[i].col, query.length()) == query) {
+                    matches.push_back(previous[i]);
+                }
+            }
+
+            if (i == previous.size() || previous[i].row - row > MAX_STEPS) {
+                break;
+            }
+            for (; row < previous[i].row; row++) {
+                it.next();
+            }
+        }
+    }
+}
\ No newline at end of file
@@ -0,0 +1,49 @@
+#ifndef TEXTSEARCH_H_
+#define TEXTSEARCH_H_
+
+#include "LineRope.h"
+
+#include <string>
+#include <string_view>
+#include <vector>
+
+// Finds every occurrence of a query in a rope of lines, for search-as-you-type.
+// Each time the query grows by a character, its matches can only be where the shorter query matched, so
+// only those places are checked again rather than the whole document, walking through them in order.
+// The matches of the last few shorter queries are kept too, so taking a character back off of the query
+// usually costs nothing.
+class TextSearch {
+public:
+    struct Match {
+        int row;
+        int col;
+    };
+
+    TextSearch();
+
+    // Find every occurrence of query in lines (including ones that overlap), in order
+    // The results stay valid until the next call; lines must be the same document as on the last call
+    // unless invalidate has been called since
+    const std::vector<Match>& search(const LineRope& lines, std::string_view query);
+    // Forget every previous result, because the document they were found in has changed
+    void invalidate();
+
+    // Return where pattern first occurs in text at or after from, or std::string_view::npos if it doesn't
+    // memchr skips ahead to each place the pattern's first character appears, many bytes at a time,
+    // and only those places are compared against the rest of the pattern
+    static size_t find(std::string_view text, std::string_view pattern, size_t from = 0);
+private:
+    // Queries searched for since the last invalidate, each one extending the one before it, and their matches
+    // Only the latest query's matches are always kept; the ones before it are kept up to a limit
+    std::vector<std::string> m_queries;
+    std::vector<std::vector<Match>> m_results;
+    std::vector<Match> m_noMatches;     // Returned for queries that can't match anything
+
+    // Find every occurrence of query by scanning every line
+    static void scan(const LineRope& lines, std::string_view query, std::vector<Match>& matches);
+    // Keep only the previous matches that are also matches of query, which must extend the previous query
+    static void narrow(const LineRope& lines, std::string_view query, const std::vector<Match>& previous,
+                       std::vector<Match>& matches);
+};
+
+#endif // TEXTSEARCH_H_
\ No newline at end of file
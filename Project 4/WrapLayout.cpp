@@ -0,0 +1,650 @@
+#include "WrapLayout.h"
+#include <string_view>
+#include <vector>
+#include <algorithm>
+
+// What a line's number of visual rows is while it's waiting to be laid out again
+const int STALE = -1;
+
+WrapLayout::WrapLayout() : m_width(0), m_built(false), m_root(nullptr), m_nextEviction(0), m_activeRow(-1),
+                           m_activeLine(nullptr) {}
+
+WrapLayout::~WrapLayout() {
+    destroy(m_root);
+}
+
+int WrapLayout::width() const {
+    return m_width;
+}
+
+void WrapLayout::setWidth(int width) {
+    if (width < 0) {
+        width = 0;
+    }
+    if (width != m_width) {
+        m_width = width;
+        clear();
+    }
+}
+
+void WrapLayout::clear() {
+    destroy(m_root);
+    m_root = nullptr;
+    m_built = false;
+    m_cache.clear();
+    m_nextEviction = 0;
+}
+
+// Time Complexity: O((K + log N) log N) for K lines added or removed, which is O(log N) for a keystroke
+void WrapLayout::markChanged(int row, int count, int newCount) {
+    // The changed lines' wrap points are out of date, and the lines after them have moved
+    for (CachedLine& cached : m_cache) {
+        if (cached.row >= row + count) {
+            cached.row += newCount - count;
+        } else if (cached.row >= row) {
+            cached.row = -1;
+        }
+    }
+
+    // Until the document has been laid out there's nothing to update
+    if (!m_built) {
+        return;
+    }
+
+    int numReplaced = std::min(count, newCount);
+    for (int i = 0; i < numReplaced; i++) {
+        m_root = markStale(m_root, row + i);
+    }
+
+    if (newCount > count) {
+        m_root = insertStale(m_root, row + count, newCount - count);
+    } else {
+        // The lines to erase may span several blocks, so erase them a block at a time
+        int numToErase = count - newCount;
+        while (numToErase > 0) {
+            int erased;
+            m_root = eraseFromBlock(m_root, row + newCount, numToErase, erased);
+            if (erased == 0) {
+                break;
+            }
+            numToErase -= erased;
+        }
+    }
+}
+
+// Time Complexity: O(log N)
+void WrapLayout::markEdited(int row, int col, int erased, int inserted) {
+    CachedLine* cached = findCached(row);
+    if (cached != nullptr) {
+        if (cached->editStart < 0) {
+            cached->editStart = col;
+            cached->editEnd = col + inserted;
+        } else {
+            // The text edited before either moves along with this edit or is partly taken out by it
+            if (cached->editEnd >= col + erased) {
+                cached->editEnd += inserted - erased;
+            } else {
+                cached->editEnd = std::min(cached->editEnd, col);
+            }
+            cached->editStart = std::min(cached->editStart, col);
+            cached->editEnd = std::max(cached->editEnd, col + inserted);
+        }
+        cached->shift += inserted - erased;
+    }
+
+    if (m_built) {
+        m_root = markStale(m_root, row);
+    }
+}
+
+void WrapLayout::setActiveLine(int row, const GapBuffer* line) {
+    m_activeRow = row;
+    m_activeLine = line;
+}
+
+int WrapLayout::size(const LineRope& lines) {
+    layOut(lines);
+    return numVisualRows(m_root);
+}
+
+// Time Complexity: O(log N) once the layout is up to date
+int WrapLayout::visualRow(const LineRope& lines, int row) {
+    layOut(lines);
+
+    int visualRow = 0;
+    Node* node = m_root;
+    while (node != nullptr) {
+        int leftLines = numLines(node->left);
+        if (row < leftLines) {
+            node = node->left;
+            continue;
+        }
+
+        // Skip over the left subtree, then either find the row in this block or skip over it too
+        visualRow += numVisualRows(node->left);
+        row -= leftLines;
+        if (row < (int) node->rows.size()) {
+            for (int i = 0; i < row; i++) {
+                visualRow += node->rows[i];
+            }
+            return visualRow;
+        }
+        visualRow += node->visualRows - numVisualRows(node->left) - numVisualRows(node->right);
+        row -= node->rows.size();
+        node = node->right;
+    }
+
+    return visualRow;
+}
+
+// Time Complexity: O(log N) once the layout is up to date
+void WrapLayout::find(const LineRope& lines, int visualRow, int& row, int& wrap) {
+    layOut(lines);
+    if (visualRow < 0) {
+        visualRow = 0;
+    }
+
+    int firstRow = 0;
+    Node* node = m_root;
+    while (node != nullptr) {
+        int leftVisualRows = numVisualRows(node->left);
+        if (visualRow < leftVisualRows) {
+            node = node->left;
+            continue;
+        }
+
+        visualRow -= leftVisualRows;
+        firstRow += numLines(node->left);
+        int blockVisualRows = node->visualRows - leftVisualRows - numVisualRows(node->right);
+        if (visualRow < blockVisualRows) {
+            for (size_t i = 0; i < node->rows.size(); i++) {
+                if (visualRow < node->rows[i]) {
+                    row = firstRow + i;
+                    wrap = visualRow;
+                    return;
+                }
+                visualRow -= node->rows[i];
+            }
+        }
+        visualRow -= blockVisualRows;
+        firstRow += node->rows.size();
+        node = node->right;
+    }
+
+    // Past the last visual row
+    row = firstRow;
+    wrap = 0;
+}
+
+void WrapLayout::locate(const LineRope& lines, int row, int col, int& wrap, int& visualCol) {
+    LineView text = line(lines, row);
+    if (m_width <= 0 || (int) text.length() <= m_width) {
+        wrap = 0;
+        visualCol = col;
+        return;
+    }
+
+    // A column right at a break belongs to the start of the next visual row
+    const std::vector<int>& starts = wrapPoints(row, text);
+    wrap = std::upper_bound(starts.begin(), starts.end(), col) - starts.begin() - 1;
+    visualCol = col - starts[wrap];
+}
+
+// Time Complexity: O(log N + R) for R visual rows, plus laying out any of their lines that aren't cached
+int WrapLayout::getRows(const LineRope& lines, int visualRow, int numRows, std::vector<LineView>& views) {
+    views.clear();
+
+    int row, wrap;
+    find(lines, visualRow, row, wrap);
+    for (LineRope::Iterator it = lines.iterate(row); (int) views.size() < numRows && !it.done(); it.next()) {
+        LineView text = line(it, row);
+        if (m_width <= 0 || (int) text.length() <= m_width) {
+            views.push_back(text);
+        } else {
+            const std::vector<int>& starts = wrapPoints(row, text);
+            for (size_t i = wrap; i < starts.size() && (int) views.size() < numRows; i++) {
+                size_t end = i + 1 < starts.size() ? starts[i + 1] : text.length();
+                views.push_back(text.substr(starts[i], end - starts[i]));
+            }
+        }
+
+        // Only the first line can start partway through
+        row++;
+        wrap = 0;
+    }
+
+    return views.size();
+}
+
+// Return how far past start the last space in the count characters of text starting at start is, or npos if there
+// isn't one
+static size_t lastSpace(std::string_view text, size_t start, size_t count) {
+    return text.substr(start, count).rfind(' ');
+}
+
+// Likewise for a line in two parts, whose part after the split is searched first since the last space is there if
+// it has one
+static size_t lastSpace(LineView line, size_t start, size_t count) {
+    size_t split = line.first.length();
+    size_t end = start + count;
+    if (end > split) {
+        size_t from = start > split ? start - split : 0;
+        size_t space = line.second.substr(from, end - split - from).rfind(' ');
+        if (space != std::string_view::npos) {
+            return split + from + space - start;
+        }
+        if (start >= split) {
+            return std::string_view::npos;
+        }
+    }
+
+    return lastSpace(line.first, start, std::min(end, split) - start);
+}
+
+// Find where the visual rows of text start and return how many there are, as wrapLine does for a line longer than width
+// Text is a std::string_view or a LineView, so that a line in one part doesn't pay for checking where the split is
+template <typename Text>
+static int wrapText(Text text, int width, std::vector<int>* starts) {
+    int numRows = 1;
+    size_t length = text.length();
+    size_t start = 0;
+    while (length - start > (size_t) width) {
+        // Break after the last space that still fits on the row, or at the width if there isn't one
+        // Only the row itself is searched, so a line with no spaces costs O(L) rather than O(L^2 / width)
+        size_t space = lastSpace(text, start, width);
+        start = space == std::string_view::npos ? start + width : start + space + 1;
+
+        numRows++;
+        if (starts != nullptr) {
+            starts->push_back(start);
+        }
+    }
+
+    return numRows;
+}
+
+int WrapLayout::wrapLine(LineView line, int width, std::vector<int>* starts) {
+    if (starts != nullptr) {
+        starts->clear();
+        starts->push_back(0);
+    }
+    if (width <= 0 || line.length() <= (size_t) width) {
+        return 1;
+    }
+
+    // Every line but the one being typed into is all in first
+    return line.second.empty() ? wrapText(line.first, width, starts) : wrapText(line, width, starts);
+}
+
+LineView WrapLayout::line(const LineRope& lines, int row) const {
+    return row == m_activeRow ? m_activeLine->view() : LineView(lines.view(row));
+}
+
+LineView WrapLayout::line(const LineRope::Iterator& it, int row) const {
+    return row == m_activeRow ? m_activeLine->view() : LineView(it.view());
+}
+
+void WrapLayout::layOut(const LineRope& lines) {
+    if (m_built) {
+        if (m_root != nullptr && m_root->stale > 0) {
+            layOutStale(lines, m_root, 0);
+        }
+        return;
+    }
+
+    // Lay out the whole document in one pass, cutting it into blocks as it goes
+    std::vector<Node*> blocks;
+    Node* block = nullptr;
+    int row = 0;
+    for (LineRope::Iterator it = lines.iterate(0); !it.done(); it.next()) {
+        if (block == nullptr || block->rows.size() == BLOCK_LINES) {
+            block = createNode();
+            block->rows.reserve(BLOCK_LINES);
+            blocks.push_back(block);
+        }
+        block->rows.push_back(wrapLine(line(it, row), m_width, nullptr));
+        row++;
+    }
+
+    m_root = build(blocks, 0, blocks.size());
+    m_built = true;
+}
+
+// Time Complexity: O(S log N) for S stale lines, since only subtrees with stale lines in them are visited
+void WrapLayout::layOutStale(const LineRope& lines, Node* node, int firstRow) {
+    if (node == nullptr || node->stale == 0) {
+        return;
+    }
+
+    layOutStale(lines, node->left, firstRow);
+    int row = firstRow + numLines(node->left);
+    for (size_t i = 0; i < node->rows.size(); i++) {
+        // A line whose wrap points are cached is most likely the one being typed into, and they're quicker
+        // to bring up to date than the line is to wrap
+        if (node->rows[i] == STALE) {
+            LineView text = line(lines, row + i);
+            if (findCached(row + i) != nullptr) {
+                node->rows[i] = wrapPoints(row + i, text).size();
+            } else {
+                node->rows[i] = wrapLine(text, m_width, nullptr);
+            }
+        }
+    }
+    layOutStale(lines, node->right, row + node->rows.size());
+    update(node);
+}
+
+const std::vector<int>& WrapLayout::wrapPoints(int row, LineView line) {
+    CachedLine* found = findCached(row);
+    if (found != nullptr) {
+        if (found->editStart >= 0) {
+            rewrap(*found, line);
+        }
+        return found->starts;
+    }
+
+    // Replace the cached lines in turn once the cache is full, reusing their vectors
+    CachedLine* cached;
+    if ((int) m_cache.size() < CACHE_LINES) {
+        m_cache.emplace_back();
+        cached = &m_cache.back();
+    } else {
+        cached = &m_cache[m_nextEviction];
+        m_nextEviction = (m_nextEviction + 1) % CACHE_LINES;
+    }
+
+    cached->row = row;
+    cached->editStart = -1;
+    cached->shift = 0;
+    wrapLine(line, m_width, &cached->starts);
+    return cached->starts;
+}
+
+WrapLayout::CachedLine* WrapLayout::findCached(int row) {
+    for (CachedLine& cached : m_cache) {
+        if (cached.row == row) {
+            return &cached;
+        }
+    }
+    return nullptr;
+}
+
+// Time Complexity: O(W) for each visual row between the one before the edits and the first break after them
+// that lines up with an old one, plus O(L / W) to shift the breaks after that
+void WrapLayout::rewrap(CachedLine& cached, LineView line) {
+    std::vector<int>& starts = cached.starts;
+
+    // A visual row breaks in the same place as before if all of it comes before the edits
+    size_t kept = 1;
+    while (kept < starts.size() && starts[kept - 1] + m_width < cached.editStart) {
+        kept++;
+    }
+    m_rewrapped.assign(starts.begin(), starts.begin() + kept);
+
+    // Wrap the line from there the way wrapLine does, until a break past the edits falls where an old one did,
+    // shifted by the edits; everything after that is the same text as before, so it breaks the same way
+    size_t length = line.length();
+    size_t start = starts[kept - 1];
+    size_t next = kept;     // The first old break that a new one could still line up with
+    while (length - start > (size_t) m_width) {
+        size_t space = lastSpace(line, start, m_width);
+        start = space == std::string_view::npos ? start + m_width : start + space + 1;
+        m_rewrapped.push_back(start);
+
+        if ((int) start >= cached.editEnd) {
+            int oldStart = start - cached.shift;
+            while (next < starts.size() && starts[next] < oldStart) {
+                next++;
+            }
+            if (next < starts.size() && starts[next] == oldStart) {
+                for (next++; next < starts.size(); next++) {
+                    m_rewrapped.push_back(starts[next] + cached.shift);
+                }
+                break;
+            }
+        }
+    }
+
+    starts.swap(m_rewrapped);
+    cached.editStart = -1;
+    cached.shift = 0;
+}
+
+WrapLayout::Node* WrapLayout::createNode() {
+    Node* node = new Node;
+    node->lines = 0;
+    node->visualRows = 0;
+    node->stale = 0;
+    node->height = 1;
+    node->left = nullptr;
+    node->right = nullptr;
+    return node;
+}
+
+void WrapLayout::destroy(Node* node) {
+    if (node == nullptr) {
+        return;
+    }
+
+    destroy(node->left);
+    destroy(node->right);
+    delete node;
+}
+
+int WrapLayout::height(Node* node) {
+    return node == nullptr ? 0 : node->height;
+}
+
+int WrapLayout::numLines(Node* node) {
+    return node == nullptr ? 0 : node->lines;
+}
+
+int WrapLayout::numVisualRows(Node* node) {
+    return node == nullptr ? 0 : node->visualRows;
+}
+
+void WrapLayout::update(Node* node) {
+    int leftHeight = height(node->left);
+    int rightHeight = height(node->right);
+    node->height = (leftHeight > rightHeight ? leftHeight : rightHeight) + 1;
+
+    int visualRows = 0;
+    int stale = 0;
+    for (int rows : node->rows) {
+        if (rows == STALE) {
+            stale++;
+        } else {
+            visualRows += rows;
+        }
+    }
+
+    node->lines = numLines(node->left) + numLines(node->right) + node->rows.size();
+    node->visualRows = numVisualRows(node->left) + numVisualRows(node->right) + visualRows;
+    node->stale = stale;
+    if (node->left != nullptr) {
+        node->stale += node->left->stale;
+    }
+    if (node->right != nullptr) {
+        node->stale += node->right->stale;
+    }
+}
+
+WrapLayout::Node* WrapLayout::rotateLeft(Node* node) {
+    Node* newRoot = node->right;
+    node->right = newRoot->left;
+    newRoot->left = node;
+
+    // The old root is now below the new root, so it must be updated first
+    update(node);
+    update(newRoot);
+    return newRoot;
+}
+
+WrapLayout::Node* WrapLayout::rotateRight(Node* node) {
+    Node* newRoot = node->left;
+    node->left = newRoot->right;
+    newRoot->right = node;
+
+    update(node);
+    update(newRoot);
+    return newRoot;
+}
+
+WrapLayout::Node* WrapLayout::rebalance(Node* node) {
+    update(node);
+    int balance = height(node->left) - height(node->right);
+
+    if (balance > 1) {
+        // Left-right case: straighten the left child out first
+        if (height(node->left->left) < height(node->left->right)) {
+            node->left = rotateLeft(node->left);
+        }
+        return rotateRight(node);
+    } else if (balance < -1) {
+        // Right-left case: straighten the right child out first
+        if (height(node->right->right) < height(node->right->left)) {
+            node->right = rotateRight(node->right);
+        }
+        return rotateLeft(node);
+    }
+
+    return node;
+}
+
+WrapLayout::Node* WrapLayout::build(std::vector<Node*>& blocks, int first, int last) {
+    if (first >= last) {
+        return nullptr;
+    }
+
+    int mid = first + (last - first) / 2;
+    Node* node = blocks[mid];
+    node->left = build(blocks, first, mid);
+    node->right = build(blocks, mid + 1, last);
+    update(node);
+    return node;
+}
+
+// Time Complexity: O(|height(left) - height(right)|) since it only walks down the taller tree's spine
+WrapLayout::Node* WrapLayout::join(Node* left, Node* middle, Node* right) {
+    if (height(left) > height(right) + 1) {
+        left->right = join(left->right, middle, right);
+        return rebalance(left);
+    }
+    if (height(right) > height(left) + 1) {
+        right->left = join(left, middle, right->left);
+        return rebalance(right);
+    }
+
+    // The trees are close enough in height to hang off of the middle node directly
+    middle->left = left;
+    middle->right = right;
+    update(middle);
+    return middle;
+}
+
+WrapLayout::Node* WrapLayout::concat(Node* left, Node* right) {
+    if (left == nullptr) {
+        return right;
+    }
+    if (right == nullptr) {
+        return left;
+    }
+
+    Node* middle;
+    right = detachMin(right, middle);
+    return join(left, middle, right);
+}
+
+WrapLayout::Node* WrapLayout::detachMin(Node* node, Node*& min) {
+    if (node->left == nullptr) {
+        min = node;
+        return node->right;
+    }
+
+    node->left = detachMin(node->left, min);
+    return rebalance(node);
+}
+
+WrapLayout::Node* WrapLayout::markStale(Node* node, int row) {
+    if (node == nullptr) {
+        return nullptr;
+    }
+
+    int leftLines = numLines(node->left);
+    if (row < leftLines) {
+        node->left = markStale(node->left, row);
+    } else if (row < leftLines + (int) node->rows.size()) {
+        node->rows[row - leftLines] = STALE;
+    } else {
+        node->right = markStale(node->right, row - leftLines - node->rows.size());
+    }
+
+    update(node);
+    return node;
+}
+
+WrapLayout::Node* WrapLayout::insertStale(Node* node, int row, int count) {
+    if (node == nullptr) {
+        node = createNode();
+    }
+
+    // A big enough insertion can make a subtree many levels taller, which a rotation or two can't fix,
+    // so subtrees are put back together with join instead of rebalance
+    int leftLines = numLines(node->left);
+    int blockLines = node->rows.size();
+    if (row < leftLines) {
+        node->left = insertStale(node->left, row, count);
+        return join(node->left, node, node->right);
+    } else if (row > leftLines + blockLines) {
+        node->right = insertStale(node->right, row - leftLines - blockLines, count);
+        return join(node->left, node, node->right);
+    }
+
+    node->rows.insert(node->rows.begin() + (row - leftLines), count, STALE);
+
+    // Split a block that got too big into blocks of about BLOCK_LINES lines, keeping the first one in this node
+    if ((int) node->rows.size() > MAX_BLOCK_LINES) {
+        int numBlocks = (node->rows.size() + BLOCK_LINES - 1) / BLOCK_LINES;
+        std::vector<Node*> blocks;
+        size_t firstEnd = node->rows.size() / numBlocks;
+        for (int i = 1; i < numBlocks; i++) {
+            Node* block = createNode();
+            block->rows.assign(node->rows.begin() + i * node->rows.size() / numBlocks,
+                               node->rows.begin() + (i + 1) * node->rows.size() / numBlocks);
+            blocks.push_back(block);
+        }
+        node->rows.resize(firstEnd);
+        node->right = concat(build(blocks, 0, blocks.size()), node->right);
+    }
+
+    return join(node->left, node, node->right);
+}
+
+WrapLayout::Node* WrapLayout::eraseFromBlock(Node* node, int row, int count, int& erased) {
+    if (node == nullptr) {
+        erased = 0;
+        return nullptr;
+    }
+
+    int leftLines = numLines(node->left);
+    int blockLines = node->rows.size();
+    if (row < leftLines) {
+        node->left = eraseFromBlock(node->left, row, count, erased);
+    } else if (row >= leftLines + blockLines) {
+        node->right = eraseFromBlock(node->right, row - leftLines - blockLines, count, erased);
+    } else {
+        int offset = row - leftLines;
+        erased = std::min(count, blockLines - offset);
+        node->rows.erase(node->rows.begin() + offset, node->rows.begin() + offset + erased);
+
+        // An empty block is taken out of the tree altogether
+        if (node->rows.empty()) {
+            Node* left = node->left;
+            Node* right = node->right;
+            delete node;
+            return concat(left, right);
+        }
+    }
+
+    return rebalance(node);
+}
\ No newline at end of file
@@ -0,0 +1,148 @@
+#ifndef WRAPLAYOUT_H_
+#define WRAPLAYOUT_H_
+
+#include "LineRope.h"
+#include "GapBuffer.h"
+#include "LineView.h"
+
+#include <string_view>
+#include <vector>
+
+// Soft-wraps the lines of a document into visual rows no wider than a given width, for drawing long lines
+// without scrolling sideways. A line is broken after the last space that fits on a row, or at the width if
+// no space does.
+// How many visual rows each line takes up is kept in a height-balanced (AVL) tree of blocks of consecutive
+// lines, and every node stores the number of lines and of visual rows in its subtree, so finding the line
+// that a visual row falls on takes O(log N) time no matter how far down the document it is. Edits are
+// reported as they happen and only mark the lines they touched as stale; those are laid out again the next
+// time the layout is asked for anything, so a keystroke costs one line's layout rather than the document's.
+// Where each line breaks is only worked out for lines being drawn, and kept for a handful of recent lines,
+// so scrolling within a huge line doesn't lay all of it out again every frame, and typing into one only wraps
+// the visual rows around the edit again.
+class WrapLayout {
+public:
+    WrapLayout();
+    ~WrapLayout();
+
+    // Return the width lines are wrapped at, or 0 if they aren't wrapped
+    int width() const;
+    // Wrap lines at width columns from now on (0 turns wrapping off), laying the document out again if it changed
+    void setWidth(int width);
+    // Forget the layout of every line, because the whole document has been replaced
+    // The document is laid out again, in O(N) time, the next time it's needed
+    void clear();
+    // Record that count rows starting at row were replaced by newCount rows
+    // (so an edit within a line is markChanged(row, 1, 1) and splitting a line is markChanged(row, 1, 2))
+    void markChanged(int row, int count, int newCount);
+    // Record that inserted characters replaced erased ones at col, within the line at row
+    // If the line's wrap points are cached, they're brought up to date from the visual row before col rather
+    // than by wrapping the whole line again, since the rows before that can't have changed
+    void markEdited(int row, int col, int erased, int inserted);
+    // Read the line at row from line instead of from the document, since that's where it's being typed into
+    // (a row of -1 means every line is read from the document); line has to stay alive until this is undone
+    void setActiveLine(int row, const GapBuffer* line);
+
+    // The functions below bring the layout up to date with lines, which must be the document every change
+    // was marked in
+
+    // Return the number of visual rows in the document
+    int size(const LineRope& lines);
+    // Return the first visual row of the line at row
+    int visualRow(const LineRope& lines, int row);
+    // Find the line that visualRow falls on, storing its row and which of its visual rows it is in row and wrap
+    void find(const LineRope& lines, int visualRow, int& row, int& wrap);
+    // Find which of a line's visual rows col falls on, and the column within that visual row
+    void locate(const LineRope& lines, int row, int col, int& wrap, int& visualCol);
+    // Fill views with the text of up to numRows visual rows starting at visualRow, returning how many there were
+    // The views are only valid as long as views of the lines themselves would be
+    int getRows(const LineRope& lines, int visualRow, int numRows, std::vector<LineView>& views);
+
+    // Find where a line's visual rows start when it's wrapped at width columns (0 meaning it isn't wrapped)
+    // and return how many there are; starts gets the offset each of them starts at, unless it's null
+    // A line that fits takes O(1) time, and a longer one O(L)
+    static int wrapLine(LineView line, int width, std::vector<int>* starts);
+private:
+    // Lines per block when blocks are built, and the most a block can grow to before it's split in two
+    static const int BLOCK_LINES = 64;
+    static const int MAX_BLOCK_LINES = 2 * BLOCK_LINES;
+    // How many lines' wrap points are remembered
+    static const int CACHE_LINES = 64;
+
+    struct Node {
+        std::vector<int> rows;  // Number of visual rows of each line in the block, or -1 if it's stale
+        int lines;          // Number of lines in the subtree rooted at this node
+        int visualRows;     // Number of visual rows in the subtree, not counting stale lines
+        int stale;          // Number of stale lines in the subtree
+        int height;         // Height of the subtree rooted at this node
+        Node* left;
+        Node* right;
+    };
+    // Where the visual rows of a recently drawn line start
+    // Edits made to it within the line since then are remembered rather than wrapping it again straight away
+    struct CachedLine {
+        int row;
+        std::vector<int> starts;
+        int editStart;  // Where the text that was edited starts, or -1 if the line hasn't been edited
+        int editEnd;    // Where the text that was edited ends, in the line as it is now
+        int shift;      // How many characters longer the edits have made the line
+    };
+
+    int m_width;
+    bool m_built;       // Whether the tree holds every line, or the document has to be laid out from scratch
+    Node* m_root;
+    std::vector<CachedLine> m_cache;
+    int m_nextEviction;     // Which cached line gets replaced when the cache is full
+    std::vector<int> m_rewrapped;   // Where a cached line's wrap points are put while they're brought up to date
+    int m_activeRow;        // The row being typed into, or -1 if there isn't one
+    const GapBuffer* m_activeLine;  // Where the text of the row being typed into is
+
+    // The tree's nodes belong to one layout, so it can't be copied
+    WrapLayout(const WrapLayout&);
+    WrapLayout& operator=(const WrapLayout&);
+
+    // Return the text of the line at row, from the gap buffer if it's being typed into
+    LineView line(const LineRope& lines, int row) const;
+    // Return the text of the line at row, which it is on, from the gap buffer if it's being typed into
+    LineView line(const LineRope::Iterator& it, int row) const;
+    // Lay out every line of the document if the tree was cleared, and every stale line otherwise
+    void layOut(const LineRope& lines);
+    // Lay out the stale lines of a subtree whose first line is at firstRow
+    void layOutStale(const LineRope& lines, Node* node, int firstRow);
+    // Return where the visual rows of the line at row start, laying it out if it isn't cached
+    const std::vector<int>& wrapPoints(int row, LineView line);
+    // Return the cached wrap points of the line at row, or null if they aren't cached
+    CachedLine* findCached(int row);
+    // Bring the wrap points of a cached line that was edited up to date with its text, which is line
+    // Only the visual rows from the one before the edits up to where the breaks line up again are wrapped
+    void rewrap(CachedLine& cached, LineView line);
+
+    static Node* createNode();
+    static void destroy(Node* node);
+    static int height(Node* node);
+    static int numLines(Node* node);
+    static int numVisualRows(Node* node);
+    // Recompute a node's counts and height from its block and its children
+    static void update(Node* node);
+    static Node* rotateLeft(Node* node);
+    static Node* rotateRight(Node* node);
+    // Restore the AVL property at a node whose children are balanced
+    static Node* rebalance(Node* node);
+    // Build a balanced tree out of blocks[first, last)
+    static Node* build(std::vector<Node*>& blocks, int first, int last);
+    // The functions below take the root of a subtree and return its new root
+
+    // Join two trees with a node in between them, where every line of left comes before every line of right
+    static Node* join(Node* left, Node* middle, Node* right);
+    // Join two trees without a node in between them
+    static Node* concat(Node* left, Node* right);
+    // Detach the leftmost node of a subtree, storing it in min
+    static Node* detachMin(Node* node, Node*& min);
+    // Mark the line at row as stale
+    static Node* markStale(Node* node, int row);
+    // Insert count stale lines so that the first one ends up at row, splitting the block they land in if it gets too big
+    static Node* insertStale(Node* node, int row, int count);
+    // Erase up to count lines starting at row from the one block holding row, storing how many were erased in erased
+    static Node* eraseFromBlock(Node* node, int row, int count, int& erased);
+};
+
+#endif // WRAPLAYOUT_H_
\ No newline at end of file
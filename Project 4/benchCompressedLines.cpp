@@ -0,0 +1,112 @@
+#include "MappedFile.h"
+#include "LineRope.h"
+#include <iostream>
+#include <fstream>
+#include <string>
+#include <memory>
+#include <chrono>
+#include <random>
+#include <cstdio>
+#include <cassert>
+
+using namespace std;
+
+// Return how much of this process is resident in memory, in MB, or -1 if that can't be found out
+static double residentMB() {
+    ifstream status("/proc/self/status");
+    string field;
+    while (status >> field) {
+        if (field == "VmRSS:") {
+            double kb;
+            status >> kb;
+            return kb / 1024;
+        }
+    }
+    return -1;
+}
+
+// Load the file, then read through all of it and jump around in it the way scrolling would
+static void run(const string& fileName, bool compress) {
+    const int SCREEN_ROWS = 50;
+    const int NUM_JUMPS = 10000;
+
+    double residentBefore = residentMB();
+    chrono::steady_clock::time_point start = chrono::steady_clock::now();
+    shared_ptr<MappedFile> file = make_shared<MappedFile>();
+    assert(file->open(fileName, compress));
+    LineRope lines;
+    lines.assign(file);
+    double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+    cout << (compress ? "Compressed:" : "Mapped:") << endl;
+    cout << "  load:               " << seconds << " s, " << file->memoryUsage() / 1e6 << " MB of contents and index" << endl;
+
+    // Scroll through the whole document a screen at a time
+    long long checksum = 0;
+    start = chrono::steady_clock::now();
+    for (LineRope::Iterator it = lines.iterate(0); !it.done(); it.next()) {
+        checksum += it.view().length();
+    }
+    seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+    cout << "  scroll everything:  " << seconds / lines.size() * 1e9 << " ns per line (checksum " << checksum << ")" << endl;
+    cout << "  resident:           " << residentMB() - residentBefore << " MB more than before loading" << endl;
+
+    // Jump to random places and draw a screen there
+    mt19937 rng(32);
+    uniform_int_distribution<int> randomRow(0, lines.size() - SCREEN_ROWS);
+    checksum = 0;
+    start = chrono::steady_clock::now();
+    for (int i = 0; i < NUM_JUMPS; i++) {
+        LineRope::Iterator it = lines.iterate(randomRow(rng));
+        for (int row = 0; row < SCREEN_ROWS; row++, it.next()) {
+            checksum += it.view().length();
+        }
+    }
+    seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+    cout << "  jump and draw:      " << seconds / NUM_JUMPS * 1e6 << " us per screen (checksum " << checksum << ")" << endl;
+}
+
+// Benchmark of holding a 1 GB file's lines compressed in memory instead of mapped:
+// how much memory each takes once all of it has been read, and what that costs in scrolling
+int main() {
+    const long long FILE_SIZE = 1LL << 30;
+    const string FILE_NAME = "benchCompressedLines.txt";
+
+    {
+        // Something like a log file, which is the kind of huge file that gets opened mostly to be read
+        const char* LEVELS[] = { "INFO", "INFO", "INFO", "DEBUG", "WARN", "ERROR" };
+        const char* MESSAGES[] = { "request served", "cache miss for key", "connection opened from",
+                                   "connection closed by", "retrying after timeout on", "user logged in as" };
+        mt19937 rng(32);
+        uniform_int_distribution<int> randomIndex(0, 5);
+        uniform_int_distribution<int> randomNumber(0, 99999);
+
+        ofstream outfile(FILE_NAME, ios::binary);
+        string buffer;
+        long long size = 0;
+        long long time = 1700000000000LL;
+        while (size < FILE_SIZE) {
+            time += randomNumber(rng) % 50;
+            buffer += to_string(time);
+            buffer += " [";
+            buffer += LEVELS[randomIndex(rng)];
+            buffer += "] ";
+            buffer += MESSAGES[randomIndex(rng)];
+            buffer += " id=";
+            buffer += to_string(randomNumber(rng));
+            buffer += '\n';
+
+            if (buffer.length() >= (1 << 20)) {
+                outfile.write(buffer.data(), buffer.length());
+                size += buffer.length();
+                buffer.clear();
+            }
+        }
+        outfile.write(buffer.data(), buffer.length());
+    }
+
+    run(FILE_NAME, false);
+    run(FILE_NAME, true);
+    remove(FILE_NAME.c_str());
+
+    cout << "Passed all benchmarks" << endl;
+}
\ No newline at end of file
@@ -0,0 +1,64 @@
+#include "EditJournal.h"
+#include <iostream>
+#include <fstream>
+#include <string>
+#include <vector>
+#include <chrono>
+#include <cstdio>
+#include <cassert>
+
+using namespace std;
+
+// Micro-benchmark of what the edit journal adds to every keystroke, and of reading a journal back after a crash
+int main() {
+    const int NUM_KEYSTROKES = 1000000;
+    const string FILE_NAME = "benchEditJournal.txt";
+
+    {
+        ofstream outfile(FILE_NAME);
+        outfile << "hello\nworld\n";
+    }
+
+    {
+        EditJournal journal;
+        assert(journal.open(FILE_NAME));
+
+        // Type a long line, starting a new one now and then, like the editor would record it
+        int row = 0;
+        int col = 0;
+        chrono::steady_clock::time_point start = chrono::steady_clock::now();
+        for (int i = 0; i < NUM_KEYSTROKES; i++) {
+            if (i % 80 == 79) {
+                journal.append(EditJournal::ENTER, row, col);
+                row++;
+                col = 0;
+            } else {
+                journal.append(EditJournal::INSERT, row, col, 'a' + i % 26);
+                col++;
+            }
+        }
+        double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+        cout << "EditJournal::append: " << seconds / NUM_KEYSTROKES * 1e9 << " ns per keystroke" << endl;
+
+        start = chrono::steady_clock::now();
+        assert(journal.commit());
+        seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+        cout << "EditJournal::commit: " << seconds * 1e3 << " ms for what was left" << endl;
+    }
+
+    {
+        EditJournal journal;
+        vector<EditJournal::Entry> entries;
+        chrono::steady_clock::time_point start = chrono::steady_clock::now();
+        assert(journal.recover(FILE_NAME, entries));
+        double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+        assert(entries.size() == NUM_KEYSTROKES);
+        cout << "EditJournal::recover: " << seconds / NUM_KEYSTROKES * 1e9 << " ns per keystroke" << endl;
+
+        assert(journal.open(FILE_NAME, entries.size()));
+        journal.discard();
+    }
+
+    remove(FILE_NAME.c_str());
+    cout << "Passed all benchmarks" << endl;
+}
\ No newline at end of file
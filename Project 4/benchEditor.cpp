@@ -0,0 +1,252 @@
+#include "StudentTextEditor.h"
+#include "StudentUndo.h"
+#include "StudentSpellCheck.h"
+#include <iostream>
+#include <fstream>
+#include <string>
+#include <string_view>
+#include <vector>
+#include <atomic>
+#include <algorithm>
+#include <chrono>
+#include <random>
+#include <new>
+#include <cstdlib>
+#include <cstdio>
+#include <cassert>
+
+using namespace std;
+
+// Every allocation in the process goes through here, so each keystroke's allocations can be counted
+static atomic<long long> s_numAllocations(0);
+
+void* operator new(size_t size) {
+    s_numAllocations++;
+    void* memory = malloc(size == 0 ? 1 : size);
+    if (memory == nullptr) {
+        throw bad_alloc();
+    }
+    return memory;
+}
+
+void operator delete(void* memory) noexcept {
+    free(memory);
+}
+
+void operator delete(void* memory, size_t) noexcept {
+    free(memory);
+}
+
+// One recorded keystroke. In a trace file each one is a line holding the command, followed by the character
+// typed for 'i' or the direction moved for 'm' (a digit, in the order of TextEditor::Dir)
+struct Keystroke {
+    char command;   // 'i'nsert, 'd'el, 'b'ackspace, 'e'nter, 'm'ove, or 'u'ndo
+    char arg;
+};
+
+const string DICTIONARY_FILE = "benchEditor.dict";
+const char* WORDS[] = { "the", "editor", "keeps", "every", "line", "in", "a", "rope", "so", "that", "typing",
+                        "undo", "and", "scrolling", "stay", "fast", "even", "when", "file", "is", "huge" };
+const int NUM_WORDS = sizeof(WORDS) / sizeof(WORDS[0]);
+
+// Read a trace recorded in a file, returning false if it can't be read
+static bool readTrace(const string& file, vector<Keystroke>& trace) {
+    ifstream infile(file);
+    if (!infile) {
+        return false;
+    }
+
+    string line;
+    while (getline(infile, line)) {
+        if (!line.empty()) {
+            Keystroke keystroke;
+            keystroke.command = line[0];
+            keystroke.arg = line.length() > 1 ? line[1] : 0;
+            trace.push_back(keystroke);
+        }
+    }
+    return true;
+}
+
+static void add(vector<Keystroke>& trace, char command, char arg = 0) {
+    Keystroke keystroke;
+    keystroke.command = command;
+    keystroke.arg = arg;
+    trace.push_back(keystroke);
+}
+
+// Type prose into an empty document, with the odd typo backspaced over and the odd undo
+static vector<Keystroke> typingProse(int numKeystrokes) {
+    mt19937 rng(32);
+    uniform_int_distribution<int> randomWord(0, NUM_WORDS - 1);
+    uniform_int_distribution<int> percent(0, 99);
+
+    vector<Keystroke> trace;
+    int col = 0;
+    while ((int) trace.size() < numKeystrokes) {
+        string word = WORDS[randomWord(rng)];
+        if (percent(rng) < 5) {
+            // A typo, noticed and fixed
+            add(trace, 'i', 'x');
+            add(trace, 'i', 'q');
+            add(trace, 'b');
+            add(trace, 'b');
+        }
+        for (char ch : word) {
+            add(trace, 'i', ch);
+        }
+        col += word.length() + 1;
+
+        if (col > 70) {
+            add(trace, 'e');
+            col = 0;
+        } else {
+            add(trace, 'i', ' ');
+        }
+        if (percent(rng) == 0) {
+            add(trace, 'u');
+        }
+    }
+    return trace;
+}
+
+// Hold down del at the top of the document, then backspace from further down, crossing many lines each time
+static vector<Keystroke> bulkDeletes(int numKeystrokes) {
+    vector<Keystroke> trace;
+    while ((int) trace.size() < numKeystrokes) {
+        for (int i = 0; i < 500; i++) {
+            add(trace, 'd');
+        }
+        for (int i = 0; i < 20; i++) {
+            add(trace, 'm', '0' + TextEditor::DOWN);
+        }
+        add(trace, 'm', '0' + TextEditor::END);
+        for (int i = 0; i < 500; i++) {
+            add(trace, 'b');
+        }
+    }
+    return trace;
+}
+
+// Join every line with the next one, working down the document
+static vector<Keystroke> lineJoins(int numKeystrokes) {
+    vector<Keystroke> trace;
+    while ((int) trace.size() < numKeystrokes) {
+        add(trace, 'm', '0' + TextEditor::END);
+        add(trace, 'd');
+        add(trace, 'm', '0' + TextEditor::DOWN);
+    }
+    return trace;
+}
+
+// Write a document of numLines lines of words for the editor to load
+static void writeDocument(const string& file, int numLines) {
+    mt19937 rng(32);
+    uniform_int_distribution<int> randomWord(0, NUM_WORDS - 1);
+
+    ofstream outfile(file);
+    for (int i = 0; i < numLines; i++) {
+        for (int j = 0; j < 8; j++) {
+            outfile << WORDS[randomWord(rng)] << (j < 7 ? ' ' : '\n');
+        }
+    }
+}
+
+// Replay a trace, timing each keystroke along with what the screen does after it:
+// fetching the visible lines and spell checking the line under the cursor
+static void replay(const string& name, const vector<Keystroke>& trace, const string& documentFile) {
+    const int SCREEN_ROWS = 50;
+
+    StudentUndo undo;
+    StudentTextEditor editor(&undo);
+    StudentSpellCheck spellCheck;
+    assert(spellCheck.load(DICTIONARY_FILE));
+    if (!documentFile.empty()) {
+        assert(editor.load(documentFile));
+    }
+
+    vector<double> latencies;   // In microseconds
+    latencies.reserve(trace.size());
+    vector<LineView> screen;
+    vector<string> currentLine;
+    vector<SpellCheck::Position> problems;
+    long long checksum = 0;
+
+    long long allocationsBefore = s_numAllocations;
+    chrono::steady_clock::time_point traceStart = chrono::steady_clock::now();
+    for (const Keystroke& keystroke : trace) {
+        chrono::steady_clock::time_point start = chrono::steady_clock::now();
+        switch (keystroke.command) {
+        case 'i':
+            editor.insert(keystroke.arg);
+            break;
+        case 'd':
+            editor.del();
+            break;
+        case 'b':
+            editor.backspace();
+            break;
+        case 'e':
+            editor.enter();
+            break;
+        case 'm':
+            editor.move(static_cast<TextEditor::Dir>(keystroke.arg - '0'));
+            break;
+        case 'u':
+            editor.undo();
+            break;
+        }
+
+        int row, col;
+        editor.getPos(row, col);
+        editor.getLineViews(max(0, row - SCREEN_ROWS / 2), SCREEN_ROWS, screen);
+        editor.getLines(row, 1, currentLine);
+        spellCheck.spellCheckLine(currentLine[0], problems);
+        checksum += screen.size() + problems.size();
+
+        latencies.push_back(chrono::duration<double, micro>(chrono::steady_clock::now() - start).count());
+    }
+    double seconds = chrono::duration<double>(chrono::steady_clock::now() - traceStart).count();
+    long long numAllocations = s_numAllocations - allocationsBefore;
+
+    sort(latencies.begin(), latencies.end());
+    auto percentile = [&latencies](double p) { return latencies[min(latencies.size() - 1, (size_t) (p * latencies.size()))]; };
+    cout << name << ": " << trace.size() << " keystrokes, " << trace.size() / seconds << " per second, "
+         << (double) numAllocations / trace.size() << " allocations each (checksum " << checksum << ")" << endl;
+    cout << "  latency in us: p50 " << percentile(0.5) << ", p90 " << percentile(0.9) << ", p99 " << percentile(0.99)
+         << ", p99.9 " << percentile(0.999) << ", max " << latencies.back() << endl;
+}
+
+// Benchmark of keystroke latency, replaying synthetic traces (or one recorded in the file given as an argument)
+// against the editor, its undo history, and the spell checker, with no screen attached
+int main(int argc, char* argv[]) {
+    const string DOCUMENT_FILE = "benchEditor.txt";
+    const string HUGE_DOCUMENT_FILE = "benchEditorHuge.txt";
+
+    {
+        ofstream outfile(DICTIONARY_FILE);
+        for (const char* word : WORDS) {
+            outfile << word << '\n';
+        }
+    }
+
+    if (argc > 1) {
+        // A recorded trace is replayed against the document in the second argument, or an empty one
+        vector<Keystroke> trace;
+        assert(readTrace(argv[1], trace));
+        replay(argv[1], trace, argc > 2 ? argv[2] : "");
+    } else {
+        writeDocument(DOCUMENT_FILE, 100000);
+        writeDocument(HUGE_DOCUMENT_FILE, 2000000);
+
+        replay("Typing prose", typingProse(200000), "");
+        replay("Bulk deletes", bulkDeletes(200000), DOCUMENT_FILE);
+        replay("Line joins on a huge file", lineJoins(200000), HUGE_DOCUMENT_FILE);
+
+        remove(DOCUMENT_FILE.c_str());
+        remove(HUGE_DOCUMENT_FILE.c_str());
+    }
+    remove(DICTIONARY_FILE.c_str());
+
+    cout << "Passed all benchmarks" << endl;
+}
\ No newline at end of file
@@ -0,0 +1,73 @@
+#include "StudentTextEditor.h"
+#include "StudentUndo.h"
+#include <iostream>
+#include <fstream>
+#include <string>
+#include <vector>
+#include <chrono>
+#include <cstdio>
+#include <cassert>
+
+using namespace std;
+
+const int LINE_LENGTH = 100000;
+const int NUM_KEYSTROKES = 20000;
+const int SCREEN_ROWS = 50;
+const string FILE_NAME = "benchGapBuffer.txt";
+
+// Type into the middle of a long line, doing what a screen would after every keystroke, and return the
+// time per keystroke in microseconds
+template <typename Redraw>
+static double typeAndRedraw(int wrapWidth, Redraw redraw) {
+    StudentUndo undo;
+    StudentTextEditor editor(&undo);
+    assert(editor.load(FILE_NAME));
+    editor.setWrapWidth(wrapWidth);
+    for (int i = 0; i < LINE_LENGTH / 2; i++) {
+        editor.move(TextEditor::RIGHT);
+    }
+    redraw(editor);
+
+    chrono::steady_clock::time_point start = chrono::steady_clock::now();
+    for (int i = 0; i < NUM_KEYSTROKES; i++) {
+        editor.insert(i % 10 == 9 ? ' ' : 'a' + i % 26);
+        redraw(editor);
+    }
+    double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+    return seconds / NUM_KEYSTROKES * 1e6;
+}
+
+// Benchmark of typing into the middle of a 100 KB line while the screen is redrawn after every keystroke,
+// which is what the gap buffer is there for: neither the keystroke nor the redraw should touch the whole line
+int main() {
+    {
+        ofstream outfile(FILE_NAME);
+        for (int i = 0; i < LINE_LENGTH; i++) {
+            outfile << (i % 8 == 7 ? ' ' : (char) ('a' + i % 26));
+        }
+        outfile << "\nsecond line\n";
+    }
+
+    vector<LineView> views;
+    long long checksum = 0;
+    cout << "Insert alone:          " << typeAndRedraw(0, [](StudentTextEditor&) {}) << " us per keystroke" << endl;
+    cout << "Insert + getLineViews: " << typeAndRedraw(0, [&](StudentTextEditor& editor) {
+        checksum += editor.getLineViews(0, SCREEN_ROWS, views);
+    }) << " us per keystroke" << endl;
+    cout << "Insert + changedLines: " << typeAndRedraw(0, [&](StudentTextEditor& editor) {
+        checksum += editor.changedLines().size();
+    }) << " us per keystroke" << endl;
+    for (int width : { 0, 80 }) {
+        cout << "Insert + visual redraw, wrap width " << width << ": " << typeAndRedraw(width, [&](StudentTextEditor& editor) {
+            int visualRow, visualCol;
+            editor.getVisualPos(visualRow, visualCol);
+            checksum += editor.getVisualRowViews(max(0, visualRow - SCREEN_ROWS / 2), SCREEN_ROWS, views);
+            checksum += editor.visualRowCount();
+        }) << " us per keystroke" << endl;
+    }
+    cout << "(checksum " << checksum << ")" << endl;
+
+    remove(FILE_NAME.c_str());
+    remove((FILE_NAME + ".journal").c_str());
+    cout << "Passed all benchmarks" << endl;
+}
\ No newline at end of file
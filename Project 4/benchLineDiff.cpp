@@ -0,0 +1,89 @@
+#include "LineDiff.h"
+#include "LineRope.h"
+#include "MappedFile.h"
+#include <iostream>
+#include <fstream>
+#include <string>
+#include <vector>
+#include <memory>
+#include <chrono>
+#include <random>
+#include <cstdio>
+#include <cassert>
+
+using namespace std;
+
+// Benchmark of keeping the gutter's modified-line markers up to date while editing a large file
+int main() {
+    const int NUM_LINES = 1000000;
+    const int NUM_EDITS = 1000;
+    const int NUM_KEYSTROKES = 10000;
+    const string FILE_NAME = "benchLineDiff.txt";
+
+    {
+        ofstream outfile(FILE_NAME);
+        for (int i = 0; i < NUM_LINES; i++) {
+            outfile << "line " << i << " of the file\n";
+        }
+    }
+
+    shared_ptr<MappedFile> file = make_shared<MappedFile>();
+    assert(file->open(FILE_NAME));
+    LineRope lines;
+    lines.assign(file);
+
+    LineDiff diff;
+    diff.reset(lines);
+
+    // Scatter edits through the file: changed lines, and a line split in two now and then
+    mt19937 rng(32);
+    uniform_int_distribution<int> randomRow(0, NUM_LINES - 1);
+    for (int i = 0; i < NUM_EDITS; i++) {
+        int row = randomRow(rng);
+        if (i % 10 == 0) {
+            lines.insert(row + 1, "a new line");
+            diff.markChanged(row, 1, 2);
+        } else {
+            lines.at(row) += " (edited)";
+            diff.markChanged(row, 1, 1);
+        }
+    }
+
+    {
+        chrono::steady_clock::time_point start = chrono::steady_clock::now();
+        size_t numChanges = diff.changes(lines).size();
+        double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+        cout << "First diff:     " << seconds * 1e3 << " ms for " << NUM_EDITS << " edits (" << numChanges << " changes)" << endl;
+    }
+
+    int row = NUM_LINES / 2;
+    string original(lines.view(row));
+    {
+        // Type into one line, updating the markers after every keystroke
+        chrono::steady_clock::time_point start = chrono::steady_clock::now();
+        for (int i = 0; i < NUM_KEYSTROKES; i++) {
+            lines.at(row) += 'x';
+            diff.markChanged(row, 1, 1);
+            assert(!diff.changes(lines).empty());
+        }
+        double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+        cout << "Per keystroke:  " << seconds / NUM_KEYSTROKES * 1e6 << " us" << endl;
+    }
+
+    {
+        // Putting a line back the way it was removes its marker
+        lines.at(row) = original;
+        diff.markChanged(row, 1, 1);
+        chrono::steady_clock::time_point start = chrono::steady_clock::now();
+        size_t numChanges = diff.changes(lines).size();
+        double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+        cout << "After revert:   " << seconds * 1e6 << " us (" << numChanges << " changes)" << endl;
+    }
+
+    lines.clear();
+    diff.reset(lines);
+    file.reset();
+    remove(FILE_NAME.c_str());
+
+    cout << "Passed all benchmarks" << endl;
+}
\ No newline at end of file
@@ -0,0 +1,68 @@
+#include "LineRope.h"
+#include <iostream>
+#include <string>
+#include <list>
+#include <iterator>
+#include <chrono>
+#include <random>
+#include <cassert>
+
+using namespace std;
+
+// Micro-benchmark of random-row access in LineRope against walking a std::list from a cursor,
+// which is what the text editor used to do for getLines and undo
+int main() {
+    const int NUM_LINES = 1000000;
+    const int NUM_LOOKUPS = 1000000;
+    const int NUM_LIST_LOOKUPS = 1000;   // Walking the list is so slow that it gets far fewer lookups
+
+    LineRope rope;
+    list<string> lines;
+    for (int i = 0; i < NUM_LINES; i++) {
+        string line = "line " + to_string(i);
+        rope.pushBack(line);
+        lines.push_back(line);
+    }
+    assert(rope.size() == NUM_LINES);
+
+    mt19937 rng(32);
+    uniform_int_distribution<int> randomRow(0, NUM_LINES - 1);
+
+    {
+        long long checksum = 0;
+        chrono::steady_clock::time_point start = chrono::steady_clock::now();
+        for (int i = 0; i < NUM_LOOKUPS; i++) {
+            checksum += rope.view(randomRow(rng)).length();
+        }
+        double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+        cout << "LineRope::view:  " << seconds / NUM_LOOKUPS * 1e9 << " ns per random row (checksum " << checksum << ")" << endl;
+    }
+
+    {
+        long long checksum = 0;
+        chrono::steady_clock::time_point start = chrono::steady_clock::now();
+        for (int i = 0; i < NUM_LOOKUPS; i++) {
+            checksum += rope.at(randomRow(rng)).length();
+        }
+        double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+        cout << "LineRope::at:    " << seconds / NUM_LOOKUPS * 1e9 << " ns per random row (checksum " << checksum << ")" << endl;
+    }
+
+    {
+        // Like the old editor, walk from wherever the previous lookup left the cursor
+        long long checksum = 0;
+        list<string>::iterator cursor = lines.begin();
+        int cursorRow = 0;
+        chrono::steady_clock::time_point start = chrono::steady_clock::now();
+        for (int i = 0; i < NUM_LIST_LOOKUPS; i++) {
+            int row = randomRow(rng);
+            advance(cursor, row - cursorRow);
+            cursorRow = row;
+            checksum += cursor->length();
+        }
+        double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+        cout << "std::list walk:  " << seconds / NUM_LIST_LOOKUPS * 1e9 << " ns per random row (checksum " << checksum << ")" << endl;
+    }
+
+    cout << "Passed all benchmarks" << endl;
+}
\ No newline at end of file
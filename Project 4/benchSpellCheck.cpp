@@ -0,0 +1,179 @@
+#include "StudentSpellCheck.h"
+#include "DoubleArrayTrie.h"
+#include "Dawg.h"
+#include <iostream>
+#include <fstream>
+#include <string>
+#include <vector>
+#include <chrono>
+#include <random>
+#include <cstdio>
+#include <cassert>
+
+using namespace std;
+
+// Return how much of this process is resident in memory, in MB, or -1 if that can't be found out
+static double residentMB() {
+    ifstream status("/proc/self/status");
+    string field;
+    while (status >> field) {
+        if (field == "VmRSS:") {
+            double kb;
+            status >> kb;
+            return kb / 1024;
+        }
+    }
+    return -1;
+}
+
+// Make up a word out of syllables
+static string makeStem(mt19937& rng) {
+    const char* ONSETS[] = { "b", "c", "d", "f", "g", "h", "l", "m", "n", "p", "r", "s", "t", "v", "w",
+                             "br", "ch", "cl", "gr", "pl", "sh", "st", "th", "tr" };
+    const char* VOWELS[] = { "a", "e", "i", "o", "u", "ea", "ou", "ai", "io" };
+    const char* CODAS[] = { "", "", "n", "r", "s", "t", "l", "nd", "st", "ck", "m" };
+    uniform_int_distribution<int> numSyllables(1, 4);
+    uniform_int_distribution<int> onset(0, 23);
+    uniform_int_distribution<int> vowel(0, 8);
+    uniform_int_distribution<int> coda(0, 10);
+
+    string stem;
+    for (int i = numSyllables(rng); i > 0; i--) {
+        stem += ONSETS[onset(rng)];
+        stem += VOWELS[vowel(rng)];
+        stem += CODAS[coda(rng)];
+    }
+    return stem;
+}
+
+// Look up random words that are in the dictionary, then misspelled ones
+static void lookUp(const string& name, StudentSpellCheck& spellCheck, const vector<string>& words,
+                   const vector<string>& misspelled, int numLookups) {
+    mt19937 rng(32);
+    uniform_int_distribution<int> randomWord(0, words.size() - 1);
+    vector<string> suggestions;
+
+    int numFound = 0;
+    chrono::steady_clock::time_point start = chrono::steady_clock::now();
+    for (int i = 0; i < numLookups; i++) {
+        numFound += spellCheck.spellCheck(words[randomWord(rng)], 0, suggestions);
+    }
+    double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+    assert(numFound == numLookups);
+    cout << name << " " << numLookups / seconds / 1e6 << " million per second (words in the dictionary)" << endl;
+
+    numFound = 0;
+    start = chrono::steady_clock::now();
+    for (int i = 0; i < numLookups; i++) {
+        numFound += spellCheck.spellCheck(misspelled[i % misspelled.size()], 0, suggestions);
+    }
+    seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+    cout << name << " " << numLookups / seconds / 1e6 << " million per second (misspelled words, "
+         << numFound * 100.0 / numLookups << "% found)" << endl;
+}
+
+// Find suggestions for every misspelled word
+static void suggest(const string& name, StudentSpellCheck& spellCheck, const vector<string>& misspelled) {
+    vector<string> suggestions;
+    long long numSuggestions = 0;
+    chrono::steady_clock::time_point start = chrono::steady_clock::now();
+    for (const string& word : misspelled) {
+        if (!spellCheck.spellCheck(word, 10, suggestions)) {
+            numSuggestions += suggestions.size();
+        }
+    }
+    double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+    cout << name << " " << seconds / misspelled.size() * 1e6 << " us per misspelled word ("
+         << numSuggestions << " suggestions)" << endl;
+}
+
+// Benchmark of loading a large dictionary, and of spell checking words against it
+int main() {
+    const int NUM_STEMS = 60000;
+    const int NUM_LOOKUPS = 2000000;
+    const int NUM_SUGGESTIONS = 20000;
+    const string FILE_NAME = "benchSpellCheck.dict";
+    const string COMPILED_FILE_NAME = "benchSpellCheck.bin";
+
+    // Something like an English word list: stems with the usual endings, so many words share prefixes and suffixes
+    vector<string> words;
+    {
+        const char* SUFFIXES[] = { "", "s", "'s", "ed", "er", "ers", "ing", "ings", "ly", "ness", "tion", "tions",
+                                   "able", "ment", "ments", "est" };
+        mt19937 rng(32);
+        uniform_int_distribution<int> coin(0, 1);
+        ofstream outfile(FILE_NAME);
+        for (int i = 0; i < NUM_STEMS; i++) {
+            string stem = makeStem(rng);
+            for (const char* suffix : SUFFIXES) {
+                if (coin(rng) == 0) {
+                    words.push_back(stem + suffix);
+                    outfile << words.back() << '\n';
+                }
+            }
+        }
+    }
+
+    StudentSpellCheck spellCheck;
+    double residentBefore = residentMB();
+    chrono::steady_clock::time_point start = chrono::steady_clock::now();
+    assert(spellCheck.load(FILE_NAME));
+    double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+    cout << "Load:           " << seconds * 1e3 << " ms for " << words.size() << " words, "
+         << residentMB() - residentBefore << " MB resident" << endl;
+
+    // Words with one letter changed, which mostly aren't in the dictionary
+    mt19937 rng(32);
+    uniform_int_distribution<int> randomWord(0, words.size() - 1);
+    vector<string> misspelled;
+    for (int i = 0; i < NUM_SUGGESTIONS; i++) {
+        string word = words[randomWord(rng)];
+        word[rng() % word.length()] = 'a' + rng() % 26;
+        misspelled.push_back(word);
+    }
+    lookUp("Lookups:       ", spellCheck, words, misspelled, NUM_LOOKUPS);
+
+    // The same dictionary compiled and mapped by another spell checker, the way every editor after the first would start
+    assert(spellCheck.save(COMPILED_FILE_NAME));
+    {
+        StudentSpellCheck compiledSpellCheck;
+        residentBefore = residentMB();
+        start = chrono::steady_clock::now();
+        assert(compiledSpellCheck.load(COMPILED_FILE_NAME));
+        seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+        cout << "Load compiled:  " << seconds * 1e6 << " us, " << residentMB() - residentBefore << " MB resident" << endl;
+        lookUp("Lookups mapped:", compiledSpellCheck, words, misspelled, NUM_LOOKUPS);
+        cout << "  after lookups " << residentMB() - residentBefore << " MB resident, shared with other processes" << endl;
+    }
+
+    // The same dictionary kept as a minimized word graph, which shares the endings of words too
+    {
+        StudentSpellCheck compactSpellCheck;
+        compactSpellCheck.setCompactDictionary(true);
+        residentBefore = residentMB();
+        start = chrono::steady_clock::now();
+        assert(compactSpellCheck.load(FILE_NAME));
+        seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+        cout << "Load graph:     " << seconds * 1e3 << " ms, " << residentMB() - residentBefore << " MB resident" << endl;
+        lookUp("Lookups graph: ", compactSpellCheck, words, misspelled, NUM_LOOKUPS);
+        suggest("Suggest graph: ", compactSpellCheck, misspelled);
+
+        vector<string> copy = words;
+        DoubleArrayTrie trie;
+        trie.build(copy);
+        copy = words;
+        Dawg dawg;
+        dawg.build(copy);
+        cout << "Trie:           " << trie.memoryUsage() / 1e6 << " MB" << endl;
+        cout << "Word graph:     " << dawg.memoryUsage() / 1e6 << " MB ("
+             << (double) trie.memoryUsage() / dawg.memoryUsage() << "x smaller)" << endl;
+    }
+
+    // Misspelled words that need suggestions
+    suggest("Suggestions:   ", spellCheck, misspelled);
+
+    remove(FILE_NAME.c_str());
+    remove(COMPILED_FILE_NAME.c_str());
+
+    cout << "Passed all benchmarks" << endl;
+}
\ No newline at end of file
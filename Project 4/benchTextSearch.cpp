@@ -0,0 +1,123 @@
+#include "TextSearch.h"
+#include "LineRope.h"
+#include "MappedFile.h"
+#include <iostream>
+#include <fstream>
+#include <string>
+#include <vector>
+#include <memory>
+#include <chrono>
+#include <random>
+#include <cstdio>
+#include <cassert>
+
+using namespace std;
+
+// Count the matches of query by calling std::string_view::find on every line, to check TextSearch against
+static size_t countMatches(const LineRope& lines, const string& query) {
+    size_t count = 0;
+    for (LineRope::Iterator it = lines.iterate(0); !it.done(); it.next()) {
+        string_view line = it.view();
+        for (size_t col = line.find(query); col != string_view::npos; col = line.find(query, col + 1)) {
+            count++;
+        }
+    }
+    return count;
+}
+
+// Benchmark of searching a 1 GB file, both all at once and as if the query were being typed a character at a time
+int main() {
+    const long long FILE_SIZE = 1LL << 30;
+    const string FILE_NAME = "benchTextSearch.txt";
+    const string QUERY = "searchable";
+
+    {
+        // Lines of random words, with the query hidden in a few of them
+        const char* WORDS[] = { "the", "quick", "brown", "fox", "jumps", "over", "lazy", "dog", "search", "sea", "able" };
+        mt19937 rng(32);
+        uniform_int_distribution<int> randomWord(0, 10);
+        uniform_int_distribution<int> randomLength(4, 14);
+        uniform_int_distribution<int> oneIn(0, 9999);
+
+        ofstream outfile(FILE_NAME, ios::binary);
+        string buffer;
+        long long size = 0;
+        while (size < FILE_SIZE) {
+            int numWords = randomLength(rng);
+            for (int i = 0; i < numWords; i++) {
+                buffer += oneIn(rng) == 0 ? QUERY.c_str() : WORDS[randomWord(rng)];
+                buffer += ' ';
+            }
+            buffer.back() = '\n';
+
+            if (buffer.length() >= (1 << 20)) {
+                outfile.write(buffer.data(), buffer.length());
+                size += buffer.length();
+                buffer.clear();
+            }
+        }
+        outfile.write(buffer.data(), buffer.length());
+    }
+
+    shared_ptr<MappedFile> file = make_shared<MappedFile>();
+    assert(file->open(FILE_NAME));
+    LineRope lines;
+    lines.assign(file);
+    cout << "Loaded " << lines.size() << " lines" << endl;
+
+    {
+        TextSearch search;
+        chrono::steady_clock::time_point start = chrono::steady_clock::now();
+        size_t numMatches = search.search(lines, QUERY).size();
+        double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+        cout << "Full search:          " << seconds * 1e3 << " ms, " << FILE_SIZE / seconds / (1 << 30) << " GB/s ("
+             << numMatches << " matches)" << endl;
+
+        start = chrono::steady_clock::now();
+        assert(countMatches(lines, QUERY) == numMatches);
+        seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+        cout << "string_view::find:    " << seconds * 1e3 << " ms" << endl;
+    }
+
+    {
+        // Search again after every character, starting over each time
+        TextSearch search;
+        chrono::steady_clock::time_point start = chrono::steady_clock::now();
+        for (size_t length = 1; length <= QUERY.length(); length++) {
+            search.invalidate();
+            search.search(lines, string_view(QUERY).substr(0, length));
+        }
+        double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+        cout << "Typing, from scratch: " << seconds * 1e3 / QUERY.length() << " ms per character" << endl;
+    }
+
+    {
+        // Search again after every character, only checking where the shorter query matched
+        TextSearch search;
+        vector<double> times;
+        size_t numMatches = 0;
+        for (size_t length = 1; length <= QUERY.length(); length++) {
+            chrono::steady_clock::time_point start = chrono::steady_clock::now();
+            numMatches = search.search(lines, string_view(QUERY).substr(0, length)).size();
+            times.push_back(chrono::duration<double>(chrono::steady_clock::now() - start).count());
+        }
+        cout << "Typing, incremental:  " << times[0] * 1e3 << " ms for the first character, then";
+        for (size_t i = 1; i < times.size(); i++) {
+            cout << " " << times[i] * 1e3;
+        }
+        cout << " ms" << endl;
+        assert(numMatches == countMatches(lines, QUERY));
+
+        // Taking a character back off reuses the shorter query's matches
+        chrono::steady_clock::time_point start = chrono::steady_clock::now();
+        search.search(lines, string_view(QUERY).substr(0, QUERY.length() - 1));
+        double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+        cout << "Backspace:            " << seconds * 1e6 << " us" << endl;
+    }
+
+    lines.clear();
+    file.reset();
+    remove(FILE_NAME.c_str());
+
+    cout << "Passed all benchmarks" << endl;
+}
\ No newline at end of file
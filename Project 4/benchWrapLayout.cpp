@@ -0,0 +1,116 @@
+#include "StudentTextEditor.h"
+#include "StudentUndo.h"
+#include "WrapLayout.h"
+#include <iostream>
+#include <fstream>
+#include <string>
+#include <string_view>
+#include <vector>
+#include <chrono>
+#include <random>
+#include <cstdio>
+#include <cassert>
+
+using namespace std;
+
+// Benchmark of drawing a soft-wrapped document of long lines: laying it out, scrolling through it by visual
+// row, jumping around in it, and typing into it, against re-wrapping every line above the screen each frame
+int main() {
+    const int NUM_LINES = 100000;
+    const int WIDTH = 80;
+    const int SCREEN_ROWS = 50;
+    const int NUM_FRAMES = 10000;
+    const int NUM_NAIVE_FRAMES = 10;
+    const string FILE_NAME = "benchWrapLayout.txt";
+
+    {
+        // Paragraphs of prose, a few hundred to a couple of thousand characters each, one per line
+        const char* WORDS[] = { "the", "layout", "of", "every", "line", "is", "kept", "in", "a", "tree",
+                                "so", "scrolling", "never", "wraps", "whole", "document", "again" };
+        mt19937 rng(32);
+        uniform_int_distribution<int> randomWord(0, 16);
+        uniform_int_distribution<int> randomLength(200, 2000);
+
+        ofstream outfile(FILE_NAME);
+        for (int i = 0; i < NUM_LINES; i++) {
+            string line;
+            int length = randomLength(rng);
+            while ((int) line.length() < length) {
+                line += WORDS[randomWord(rng)];
+                line += ' ';
+            }
+            line.back() = '\n';
+            outfile << line;
+        }
+    }
+
+    StudentUndo undo;
+    StudentTextEditor editor(&undo);
+    assert(editor.load(FILE_NAME));
+    editor.setWrapWidth(WIDTH);
+
+    chrono::steady_clock::time_point start = chrono::steady_clock::now();
+    int numVisualRows = editor.visualRowCount();
+    double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+    cout << "First layout:   " << seconds * 1e3 << " ms for " << NUM_LINES << " lines (" << numVisualRows
+         << " visual rows)" << endl;
+
+    // Scroll down one visual row per frame from the middle of the document
+    vector<LineView> views;
+    long long checksum = 0;
+    start = chrono::steady_clock::now();
+    for (int i = 0; i < NUM_FRAMES; i++) {
+        assert(editor.getVisualRowViews(numVisualRows / 2 + i, SCREEN_ROWS, views) == SCREEN_ROWS);
+        checksum += views[0].length();
+    }
+    seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+    cout << "Scroll:         " << seconds / NUM_FRAMES * 1e6 << " us per frame (checksum " << checksum << ")" << endl;
+
+    // Jump to random visual rows
+    mt19937 rng(32);
+    uniform_int_distribution<int> randomVisualRow(0, numVisualRows - SCREEN_ROWS);
+    checksum = 0;
+    start = chrono::steady_clock::now();
+    for (int i = 0; i < NUM_FRAMES; i++) {
+        assert(editor.getVisualRowViews(randomVisualRow(rng), SCREEN_ROWS, views) == SCREEN_ROWS);
+        checksum += views[0].length();
+    }
+    seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+    cout << "Jump and draw:  " << seconds / NUM_FRAMES * 1e6 << " us per frame (checksum " << checksum << ")" << endl;
+
+    // Type into a line in the middle of the document, redrawing the screen around the cursor after each keystroke
+    for (int i = 0; i < NUM_LINES / 2; i++) {
+        editor.move(TextEditor::DOWN);
+    }
+    start = chrono::steady_clock::now();
+    for (int i = 0; i < NUM_FRAMES; i++) {
+        editor.insert(i % 6 == 5 ? ' ' : 'x');
+        int visualRow, visualCol;
+        editor.getVisualPos(visualRow, visualCol);
+        editor.getVisualRowViews(visualRow - SCREEN_ROWS / 2, SCREEN_ROWS, views);
+        checksum += visualCol;
+    }
+    seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+    cout << "Type and draw:  " << seconds / NUM_FRAMES * 1e6 << " us per keystroke" << endl;
+
+    // Without a layout to go by, finding the middle of the document means wrapping every line above it
+    vector<string> lines;
+    editor.getLines(0, NUM_LINES, lines);
+    start = chrono::steady_clock::now();
+    for (int i = 0; i < NUM_NAIVE_FRAMES; i++) {
+        int visualRow = 0;
+        int row = 0;
+        while (visualRow < numVisualRows / 2) {
+            visualRow += WrapLayout::wrapLine(string_view(lines[row]), WIDTH, nullptr);
+            row++;
+        }
+        checksum += row;
+    }
+    seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+    cout << "Re-wrap above:  " << seconds / NUM_NAIVE_FRAMES * 1e6 << " us per frame" << endl;
+
+    editor.reset();
+    remove(FILE_NAME.c_str());
+
+    cout << "Passed all benchmarks" << endl;
+}
\ No newline at end of file
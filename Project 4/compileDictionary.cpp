@@ -0,0 +1,27 @@
+#include "StudentSpellCheck.h"
+#include <iostream>
+#include <string>
+
+using namespace std;
+
+// Compile a dictionary of one word per line into the form that StudentSpellCheck::load maps straight into
+// memory, so editors start up without parsing it and share one copy of it between them
+// Usage: compileDictionary <dictionary> <compiled dictionary>
+int main(int argc, char* argv[]) {
+    if (argc != 3) {
+        cerr << "Usage: " << argv[0] << " <dictionary> <compiled dictionary>" << endl;
+        return 1;
+    }
+
+    StudentSpellCheck spellCheck;
+    if (!spellCheck.load(argv[1])) {
+        cerr << "Can't read " << argv[1] << endl;
+        return 1;
+    }
+    if (!spellCheck.save(argv[2])) {
+        cerr << "Can't write " << argv[2] << endl;
+        return 1;
+    }
+
+    return 0;
+}
\ No newline at end of file
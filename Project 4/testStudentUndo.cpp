@@ -0,0 +1,89 @@
+#include "StudentTextEditor.h"
+#include "StudentUndo.h"
+#include <iostream>
+#include <string>
+#include <vector>
+#include <random>
+#include <cassert>
+
+using namespace std;
+
+// Return every line of editor
+static vector<string> allLines(const StudentTextEditor& editor) {
+    vector<string> lines;
+    editor.getLines(0, 1000000, lines);
+    return lines;
+}
+
+// Undo has to behave the same whether or not old operations are spilled to disk, so an editor whose undo history
+// is spilled on nearly every operation is driven through random edits, undos and redos next to one that
+// keeps everything in memory, and the two have to agree after every step
+int main() {
+    {
+        // Redoing onto an operation that was paged back in mustn't let the next keystroke batch into it
+        StudentUndo undo;
+        StudentUndo budgetUndo;
+        budgetUndo.setMemoryBudget(1);
+        StudentTextEditor editor(&undo);
+        StudentTextEditor budgetEditor(&budgetUndo);
+        for (StudentTextEditor* e : { &editor, &budgetEditor }) {
+            e->insert('a');
+            e->enter();
+            e->insert('b');
+            e->enter();
+            e->insert('c');
+            for (int i = 0; i < 5; i++) {
+                e->undo();
+            }
+            e->redo();
+            e->insert('x');
+            e->undo();
+        }
+        assert(allLines(editor) == vector<string>{ "a" });
+        assert(allLines(budgetEditor) == allLines(editor));
+    }
+
+    for (int seed = 1; seed <= 300; seed++) {
+        mt19937 rng(seed);
+        uniform_int_distribution<int> randomAction(0, 99);
+        StudentUndo undo;
+        StudentUndo budgetUndo;
+        budgetUndo.setMemoryBudget(1 + rng() % 512);
+        StudentTextEditor editor(&undo);
+        StudentTextEditor budgetEditor(&budgetUndo);
+
+        for (int step = 0; step < 400; step++) {
+            int action = randomAction(rng);
+            char ch = 'a' + rng() % 3;
+            TextEditor::Dir dir = (TextEditor::Dir) (rng() % 6);
+            for (StudentTextEditor* e : { &editor, &budgetEditor }) {
+                if (action < 40) {
+                    e->insert(ch);
+                } else if (action < 48) {
+                    e->enter();
+                } else if (action < 56) {
+                    e->backspace();
+                } else if (action < 62) {
+                    e->del();
+                } else if (action < 72) {
+                    e->move(dir);
+                } else if (action < 88) {
+                    e->undo();
+                } else {
+                    e->redo();
+                }
+            }
+
+            int row, col, budgetRow, budgetCol;
+            editor.getPos(row, col);
+            budgetEditor.getPos(budgetRow, budgetCol);
+            if (allLines(editor) != allLines(budgetEditor) || row != budgetRow || col != budgetCol) {
+                cout << "Undo with a memory budget differs from undo without one (seed " << seed
+                     << ", step " << step << ")" << endl;
+                assert(false);
+            }
+        }
+    }
+
+    cout << "Passed all tests" << endl;
+}
\ No newline at end of file